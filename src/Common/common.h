@@ -11,6 +11,10 @@ namespace frontend::common {
 constexpr const char* kSyntaxConfigFileName = "syntax_config.conf";
 /// @brief 词法分析机配置文件名
 constexpr const char* kDfaConfigFileName = "dfa_config.conf";
+/// @brief 直接编码的词法分析机源文件名
+constexpr const char* kDfaLexerSourceFileName = "dfa_lexer.cpp";
+/// @brief 词法分析机生成过程统计报告文件名
+constexpr const char* kDfaGenerationReportFileName = "dfa_generation_report.json";
 /// @brief char可能取值的数目
 constexpr size_t kCharNum = CHAR_MAX - CHAR_MIN + 1;
 
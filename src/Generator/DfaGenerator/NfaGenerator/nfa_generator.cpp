@@ -1,65 +1,458 @@
 ﻿#include "nfa_generator.h"
 
+#include <algorithm>
 #include <format>
+#include <iterator>
 #include <queue>
+#include <unordered_set>
 
 #define ENABLE_LOG
 #include "Logger/logger.h"
 
 namespace frontend::generator::dfa_generator::nfa_generator {
 
+namespace {
+/// @brief 解析[]内的可选字符
+/// @param[in] raw_regex_string ：表示单词的正则表达式字符串
+/// @param[in,out] next_character_index ：指向下一个读取的字符位置的下标的指针
+/// @return 返回可选字符的范围，每个范围两端按char比较且包含两端
+/// @details
+/// next_character_index调用时解引用的值应为'['右侧第一个字符的下标
+/// 成功调用后解引用的值为']'右侧第一个字符的下标
+/// @note raw_regex_string内对应[]部分必须为有效正则，否则在输出错误信息后退出
+std::vector<std::pair<char, char>> CharacterClassParse(
+    const std::string& raw_regex_string, size_t* const next_character_index) {
+  std::vector<std::pair<char, char>> ranges;
+  char character_pre;
+  // 初始化成不是']'的值从而可以进入循环
+  char character_now = '[';
+  while (character_now != ']') {
+    if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
+      LOG_ERROR("NFA Generator",
+                std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
+                            *next_character_index + 9))
+      exit(-1);
+    }
+    character_pre = character_now;
+    character_now = raw_regex_string[*next_character_index];
+    ++*next_character_index;
+    switch (character_now) {
+      case '-': {
+        // 读入另一端的字符
+        if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
+          LOG_ERROR("NFA Generator",
+                    std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
+                                *next_character_index + 9))
+          exit(-1);
+        }
+        character_now = raw_regex_string[*next_character_index];
+        ++*next_character_index;
+        if (character_now == ']') [[unlikely]] {
+          // [+-]这种正则表达式
+          break;
+        }
+        ranges.emplace_back(std::min(character_pre, character_now),
+                            std::max(character_pre, character_now));
+      } break;
+      case '\\':
+        if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
+          LOG_ERROR("NFA Generator",
+                    std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
+                                *next_character_index + 9))
+          exit(-1);
+        }
+        character_now = raw_regex_string[*next_character_index];
+        ++*next_character_index;
+        ranges.emplace_back(character_now, character_now);
+        break;
+      case ']':
+        break;
+      default:
+        ranges.emplace_back(character_now, character_now);
+        break;
+    }
+  }
+  if (ranges.empty()) [[unlikely]] {
+    LOG_ERROR("NFA Generator",
+              std::format("非法正则 {:}\n{: >{}}\n[]中为空", raw_regex_string,
+                          '^', *next_character_index + 9))
+    exit(-1);
+  }
+  return ranges;
+}
+
+/// @class RegexAstNode nfa_generator.cpp
+/// @brief Glushkov构造使用的正则语法树节点
+struct RegexAstNode {
+  /// @brief 语法树节点类型
+  enum class NodeType {
+    kCharSet,   ///< 可选字符集合，对应Glushkov构造中的一个位置
+    kConcat,    ///< 依次连接所有子节点
+    kStar,      ///< *
+    kPlus,      ///< +
+    kOptional   ///< ?
+  };
+
+  NodeType node_type;
+  /// @brief kCharSet节点可接受的字符范围，两端为转换为uint8_t后的值
+  std::vector<std::pair<uint8_t, uint8_t>> ranges;
+  /// @brief 子节点在语法树数组中的下标，重复类节点只有一个子节点
+  std::vector<size_t> children;
+};
+
+/// @brief 添加一段按char比较的字符范围到kCharSet节点
+/// @param[in] c_low ：范围下界（包含）
+/// @param[in] c_high ：范围上界（包含）
+/// @param[in,out] ranges ：kCharSet节点的字符范围，跨越0的范围分为两段添加
+void AppendCharSetRange(char c_low, char c_high,
+                        std::vector<std::pair<uint8_t, uint8_t>>* ranges) {
+  uint8_t low = static_cast<uint8_t>(c_low);
+  uint8_t high = static_cast<uint8_t>(c_high);
+  if (low > high) {
+    ranges->emplace_back(0, high);
+    ranges->emplace_back(low, UINT8_MAX);
+  } else {
+    ranges->emplace_back(low, high);
+  }
+}
+
+/// @brief 获取*，+，?对应的语法树节点类型
+/// @param[in] c_repeat ：*，+，?之一
+/// @return 返回对应的语法树节点类型
+RegexAstNode::NodeType RepeatNodeType(char c_repeat) {
+  switch (c_repeat) {
+    case '*':
+      return RegexAstNode::NodeType::kStar;
+    case '+':
+      return RegexAstNode::NodeType::kPlus;
+    default:
+      assert(c_repeat == '?');
+      return RegexAstNode::NodeType::kOptional;
+  }
+}
+
+/// @brief 将正则解析为语法树
+/// @param[in] raw_regex_string ：表示单词的正则表达式字符串
+/// @param[in,out] next_character_index ：指向下一个读取的字符位置的下标的指针
+/// @param[in,out] ast ：存储语法树节点的数组
+/// @return 返回生成的kConcat节点在ast中的下标
+/// @details
+/// 支持的语法与NfaGenerator::RegexConstruct相同，*，+，?作用于前一个字符、[]
+/// 或()，前面没有可作用的部分时忽略；读取到与调用前的'('匹配的')'时返回，
+/// 不处理')'后的*，+，?
+size_t RegexParse(const std::string& raw_regex_string,
+                  size_t* const next_character_index,
+                  std::vector<RegexAstNode>* ast) {
+  // 依次连接的子节点
+  std::vector<size_t> children;
+  // 添加kCharSet子节点，返回该节点的字符范围
+  auto emplace_char_set =
+      [ast, &children]() -> std::vector<std::pair<uint8_t, uint8_t>>* {
+    ast->push_back(RegexAstNode{RegexAstNode::NodeType::kCharSet});
+    children.push_back(ast->size() - 1);
+    return &ast->back().ranges;
+  };
+  while (*next_character_index < raw_regex_string.size()) {
+    char c_now = raw_regex_string[*next_character_index];
+    ++*next_character_index;
+    if (c_now == ')') {
+      break;
+    }
+    switch (c_now) {
+      case '[': {
+        auto ranges = emplace_char_set();
+        for (auto [c_low, c_high] :
+             CharacterClassParse(raw_regex_string, next_character_index)) {
+          AppendCharSetRange(c_low, c_high, ranges);
+        }
+      } break;
+      case ']':
+        // RegexParse函数不应该处理]字符，应交给CharacterClassParse处理
+        assert(false);
+        break;
+      case '(': {
+        size_t child = RegexParse(raw_regex_string, next_character_index, ast);
+        children.push_back(child);
+      } break;
+      case '+':
+      case '*':
+      case '?':
+        if (!children.empty()) [[likely]] {
+          ast->push_back(
+              RegexAstNode{RepeatNodeType(c_now), {}, {children.back()}});
+          children.back() = ast->size() - 1;
+        }
+        break;
+      case '\\':
+        if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
+          LOG_ERROR("NFA Generator",
+                    std::format("非法正则 {:}", raw_regex_string))
+          LOG_ERROR("NFA Generator",
+                    std::format("{: >{}}", '^', *next_character_index + 9))
+          exit(-1);
+        }
+        c_now = raw_regex_string[*next_character_index];
+        ++*next_character_index;
+        AppendCharSetRange(c_now, c_now, emplace_char_set());
+        break;
+      case '.':
+        AppendCharSetRange(CHAR_MIN, CHAR_MAX, emplace_char_set());
+        break;
+      default:
+        AppendCharSetRange(c_now, c_now, emplace_char_set());
+        break;
+    }
+  }
+  ast->push_back(
+      RegexAstNode{RegexAstNode::NodeType::kConcat, {}, std::move(children)});
+  return ast->size() - 1;
+}
+
+/// @class GlushkovAttributes nfa_generator.cpp
+/// @brief 语法树节点在Glushkov构造中的属性
+struct GlushkovAttributes {
+  /// @brief 是否可以匹配空串
+  bool nullable;
+  /// @brief 可以作为第一个字符的位置
+  std::vector<size_t> first;
+  /// @brief 可以作为最后一个字符的位置
+  std::vector<size_t> last;
+};
+
+/// @brief 计算语法树节点的Glushkov属性并填写follow集
+/// @param[in] ast ：语法树
+/// @param[in] node_index ：要计算属性的节点在ast中的下标
+/// @param[in,out] positions ：按出现顺序存储所有位置（kCharSet节点）的下标
+/// @param[in,out] follow ：每个位置后可以跟随的位置，可能存在重复
+/// @return 返回node_index对应节点的属性
+GlushkovAttributes GlushkovAnalyze(const std::vector<RegexAstNode>& ast,
+                                   size_t node_index,
+                                   std::vector<size_t>* positions,
+                                   std::vector<std::vector<size_t>>* follow) {
+  const RegexAstNode& node = ast[node_index];
+  switch (node.node_type) {
+    case RegexAstNode::NodeType::kCharSet: {
+      size_t position = positions->size();
+      positions->push_back(node_index);
+      follow->emplace_back();
+      return GlushkovAttributes{false, {position}, {position}};
+    }
+    case RegexAstNode::NodeType::kConcat: {
+      GlushkovAttributes result{true};
+      for (size_t child : node.children) {
+        GlushkovAttributes child_attributes =
+            GlushkovAnalyze(ast, child, positions, follow);
+        // 前面部分的最后一个字符后可以跟随该部分的第一个字符
+        for (size_t position : result.last) {
+          auto& follow_positions = (*follow)[position];
+          follow_positions.insert(follow_positions.end(),
+                                  child_attributes.first.begin(),
+                                  child_attributes.first.end());
+        }
+        if (result.nullable) {
+          result.first.insert(result.first.end(),
+                              child_attributes.first.begin(),
+                              child_attributes.first.end());
+        }
+        if (child_attributes.nullable) {
+          result.last.insert(result.last.end(), child_attributes.last.begin(),
+                             child_attributes.last.end());
+        } else {
+          result.last = std::move(child_attributes.last);
+          result.nullable = false;
+        }
+      }
+      return result;
+    }
+    default: {
+      assert(node.children.size() == 1);
+      GlushkovAttributes result =
+          GlushkovAnalyze(ast, node.children.front(), positions, follow);
+      if (node.node_type != RegexAstNode::NodeType::kOptional) {
+        // 重复时最后一个字符后可以跟随第一个字符
+        for (size_t position : result.last) {
+          auto& follow_positions = (*follow)[position];
+          follow_positions.insert(follow_positions.end(), result.first.begin(),
+                                  result.first.end());
+        }
+      }
+      if (node.node_type != RegexAstNode::NodeType::kPlus) {
+        result.nullable = true;
+      }
+      return result;
+    }
+  }
+}
+}  // namespace
+
 NfaGenerator::NfaNodeId NfaGenerator::NfaNode::GetForwardNodeId(
-    char c_transfer) {
-  auto iter = nodes_forward_.find(c_transfer);
-  if (iter == nodes_forward_.end()) {
-    return NfaNodeId::InvalidId();
+    char c_transfer) const {
+  uint8_t c = static_cast<uint8_t>(c_transfer);
+  // 查找第一个low大于c的条目，只有它前面的条目可能包含c
+  auto iter = std::upper_bound(
+      nodes_forward_.begin(), nodes_forward_.end(), c,
+      [](uint8_t c, const ConditionalTransferRange& range) {
+        return c < range.low;
+      });
+  // Glushkov构造下条目可以重叠，需要检查前面所有条目
+  while (iter != nodes_forward_.begin()) {
+    --iter;
+    if (iter->high >= c) {
+      return iter->next_node_id;
+    }
+  }
+  return NfaNodeId::InvalidId();
+}
+
+void NfaGenerator::NfaNode::AddOverlappingConditionTransferRange(
+    uint8_t low, uint8_t high, NfaNodeId node_id) {
+  assert(low <= high);
+  auto iter = std::upper_bound(
+      nodes_forward_.begin(), nodes_forward_.end(), low,
+      [](uint8_t low, const ConditionalTransferRange& range) {
+        return low < range.low;
+      });
+  nodes_forward_.insert(iter, ConditionalTransferRange{low, high, node_id});
+}
+
+void NfaGenerator::NfaNode::SetConditionTransferRange(char c_low, char c_high,
+                                                      NfaNodeId node_id) {
+  assert(c_low <= c_high);
+  uint8_t low = static_cast<uint8_t>(c_low);
+  uint8_t high = static_cast<uint8_t>(c_high);
+  [[maybe_unused]] bool consistent;
+  if (low > high) {
+    // char为有符号类型且范围跨越0，转换为uint8_t后分为两段
+    consistent = InsertConditionTransferRange(0, high, node_id) &&
+                 InsertConditionTransferRange(low, UINT8_MAX, node_id);
   } else {
-    return iter->second;
+    consistent = InsertConditionTransferRange(low, high, node_id);
   }
+  assert(consistent);
 }
 
-inline void NfaGenerator::NfaNode::SetConditionTransfer(
-    char c_condition, NfaGenerator::NfaNodeId node_id) {
-  auto [iter, inserted] = nodes_forward_.emplace(c_condition, node_id);
-  assert(inserted || iter->second == node_id);
+bool NfaGenerator::NfaNode::InsertConditionTransferRange(uint8_t low,
+                                                         uint8_t high,
+                                                         NfaNodeId node_id) {
+  bool consistent = true;
+  std::vector<ConditionalTransferRange> result;
+  result.reserve(nodes_forward_.size() + 2);
+  // 添加条目，与前一个条目相邻且转移到同一节点时合并
+  auto push_range = [&result](unsigned low, unsigned high, NfaNodeId node_id) {
+    if (!result.empty() && result.back().high + 1u == low &&
+        result.back().next_node_id == node_id) {
+      result.back().high = static_cast<uint8_t>(high);
+    } else {
+      result.push_back(ConditionalTransferRange{static_cast<uint8_t>(low),
+                                                static_cast<uint8_t>(high),
+                                                node_id});
+    }
+  };
+  // [low, high]中下一个尚未确定是否存在转移条件的字符
+  unsigned next = low;
+  for (const auto& range : nodes_forward_) {
+    if (next <= high && next < range.low) {
+      // [next, range.low)中不存在转移条件，填充新的转移条件
+      push_range(next, std::min<unsigned>(range.low - 1u, high), node_id);
+    }
+    if (range.low <= high && range.high >= low &&
+        range.next_node_id != node_id) {
+      consistent = false;
+    }
+    push_range(range.low, range.high, range.next_node_id);
+    next = std::max<unsigned>(next, range.high + 1u);
+  }
+  if (next <= high) {
+    push_range(next, high, node_id);
+  }
+  nodes_forward_ = std::move(result);
+  return consistent;
 }
 
 inline void NfaGenerator::NfaNode::AddNoconditionTransfer(NfaNodeId node_id) {
-  auto [iter, inserted] = conditionless_transfer_nodes_id.insert(node_id);
-  //assert(inserted);
+  if (std::find(conditionless_transfer_nodes_id.begin(),
+                conditionless_transfer_nodes_id.end(),
+                node_id) == conditionless_transfer_nodes_id.end()) {
+    conditionless_transfer_nodes_id.push_back(node_id);
+  }
 }
 
-inline size_t NfaGenerator::NfaNode::RemoveConditionalTransfer(
-    char c_transfer) {
-  return nodes_forward_.erase(c_transfer);
+size_t NfaGenerator::NfaNode::RemoveConditionalTransfersSameAs(
+    const NfaNode& node) {
+  if (&node == this) [[unlikely]] {
+    return 0;
+  }
+  size_t removed_num = 0;
+  std::vector<ConditionalTransferRange> result;
+  result.reserve(nodes_forward_.size());
+  for (const auto& range : nodes_forward_) {
+    // range中下一个尚未确定是否移除的字符
+    unsigned next = range.low;
+    for (const auto& other_range : node.nodes_forward_) {
+      if (other_range.high < next) {
+        continue;
+      }
+      if (other_range.low > range.high) {
+        break;
+      }
+      if (other_range.next_node_id != range.next_node_id) {
+        continue;
+      }
+      // 保留[next, other_range.low)，移除与other_range重合的部分
+      if (next < other_range.low) {
+        result.push_back(ConditionalTransferRange{
+            static_cast<uint8_t>(next),
+            static_cast<uint8_t>(other_range.low - 1u), range.next_node_id});
+        next = other_range.low;
+      }
+      unsigned covered_high = std::min(other_range.high, range.high);
+      removed_num += covered_high + 1u - next;
+      next = covered_high + 1u;
+    }
+    if (next <= range.high) {
+      result.push_back(ConditionalTransferRange{
+          static_cast<uint8_t>(next), range.high, range.next_node_id});
+    }
+  }
+  nodes_forward_ = std::move(result);
+  return removed_num;
 }
 
 inline size_t NfaGenerator::NfaNode::RemoveConditionlessTransfer(
     NfaNodeId node_id) {
-  return conditionless_transfer_nodes_id.erase(node_id);
+  auto iter = std::find(conditionless_transfer_nodes_id.begin(),
+                        conditionless_transfer_nodes_id.end(), node_id);
+  if (iter == conditionless_transfer_nodes_id.end()) {
+    return 0;
+  }
+  conditionless_transfer_nodes_id.erase(iter);
+  return 1;
 }
 
-std::pair<std::unordered_set<typename NfaGenerator::NfaNodeId>,
-          typename NfaGenerator::TailNodeData>
+std::pair<std::vector<NfaGenerator::NfaNodeId>, NfaGenerator::TailNodeData>
 NfaGenerator::Closure(NfaNodeId node_id) {
-  std::unordered_set<NfaNodeId> result_set;
-  TailNodeData word_attached_data(kNotTailNodeTag);
-  std::queue<NfaNodeId> q;
-  for (auto x : node_manager_.GetIdsReferringSameObject(node_id)) {
-    q.push(x);
+#ifdef USE_GLUSHKOV_NFA_CONSTRUCT
+  // Glushkov构造不生成无条件转移也不合并节点，闭包只包含节点自身
+  return std::make_pair(std::vector<NfaNodeId>{node_id},
+                        GetTailNodeData(node_id));
+#else
+  if (++closure_mark_generation_ == 0) [[unlikely]] {
+    // 标记回绕，清除所有旧标记
+    std::fill(closure_marks_.begin(), closure_marks_.end(), 0);
+    closure_mark_generation_ = 1;
   }
-  while (!q.empty()) {
-    NfaNodeId id_now = q.front();
-    q.pop();
-    if (result_set.find(id_now) != result_set.end()) {
-      continue;
-    }
-    auto [result_iter, inserted] = result_set.insert(id_now);
-    assert(inserted);
-    auto iter = tail_nodes_.find(id_now);
+  // 结果同时作为广度优先遍历的队列
+  std::vector<NfaNodeId> result;
+  TailNodeData word_attached_data(kNotTailNodeTag);
+  NfaNodeId source_id(FindRepresentative(node_id));
+  closure_marks_[source_id] = closure_mark_generation_;
+  result.push_back(source_id);
+  for (size_t i = 0; i < result.size(); i++) {
+    const uint32_t index_now = result[i].GetRawValue();
+    const uint32_t tail_data_index = tail_data_indexes_[index_now];
     // 判断是否为尾节点
-    if (iter != tail_nodes_.end()) {
-      TailNodeData& tail_node_data_new = iter->second;
+    if (tail_data_index != kNoTailNodeData) {
+      const TailNodeData& tail_node_data_new = tail_datas_[tail_data_index];
       WordPriority priority_old = word_attached_data.second;
       WordPriority priority_new = tail_node_data_new.second;
       if (word_attached_data == kNotTailNodeTag) {
@@ -83,28 +476,68 @@ NfaGenerator::Closure(NfaNodeId node_id) {
         exit(-1);
       }
     }
-    for (auto x : GetNfaNode(id_now).GetUnconditionTransferNodesIds()) {
-      q.push(x);
+    for (uint32_t j = edge_array_.conditionless_offsets[index_now];
+         j < edge_array_.conditionless_offsets[index_now + 1]; j++) {
+      NfaNodeId next_id = edge_array_.conditionless_targets[j];
+      if (closure_marks_[next_id] != closure_mark_generation_) {
+        closure_marks_[next_id] = closure_mark_generation_;
+        result.push_back(next_id);
+      }
     }
   }
-  return std::make_pair(std::move(result_set), std::move(word_attached_data));
+  return std::make_pair(std::move(result), std::move(word_attached_data));
+#endif  // USE_GLUSHKOV_NFA_CONSTRUCT
 }
 
-std::pair<std::unordered_set<typename NfaGenerator::NfaNodeId>,
-          typename NfaGenerator::TailNodeData>
+std::pair<std::vector<NfaGenerator::NfaNodeId>, NfaGenerator::TailNodeData>
 NfaGenerator::Goto(NfaNodeId id_src, char c_transform) {
-  NfaNode& pointer_node = GetNfaNode(id_src);
-  NfaNodeId node_id = pointer_node.GetForwardNodeId(c_transform);
-  if (!node_id.IsValid()) {
-    return std::make_pair(std::unordered_set<NfaNodeId>(), kNotTailNodeTag);
+  uint8_t c = static_cast<uint8_t>(c_transform);
+  std::vector<NfaNodeId> result;
+  std::unordered_set<NfaNodeId> added_nodes;
+  TailNodeData tail_data(kNotTailNodeTag);
+  // Glushkov构造下可能有多个条目包含c_transform，合并所有转移结果
+  for (const auto& range : GetConditionalTransfers(id_src)) {
+    if (range.low > c) {
+      break;
+    }
+    if (range.high < c) {
+      continue;
+    }
+    auto [closure, tail_data_temp] = Closure(range.next_node_id);
+    for (NfaNodeId node_id : closure) {
+      if (added_nodes.insert(node_id).second) {
+        result.push_back(node_id);
+      }
+    }
+    // 不存在尾节点标记或新的标记优先级大于原来的标记则修改
+    if (tail_data_temp != kNotTailNodeTag) [[unlikely]] {
+      if (tail_data == kNotTailNodeTag ||
+          tail_data_temp.second > tail_data.second) {
+        tail_data = std::move(tail_data_temp);
+      }
+    }
   }
-  return Closure(node_id);
+  return std::make_pair(std::move(result), std::move(tail_data));
 }
 
 void NfaGenerator::NfaInit() {
-  tail_nodes_.clear();
-  node_manager_.MultimapObjectManagerInit();
-  head_node_id_ = node_manager_.EmplaceObject();  // 添加头结点
+  nodes_.clear();
+  merge_parents_.clear();
+  tail_data_indexes_.clear();
+  tail_datas_.clear();
+  edge_array_ = EdgeArray();
+  closure_marks_.clear();
+  closure_mark_generation_ = 0;
+  head_node_id_ = EmplaceNode();  // 添加头结点
+}
+
+NfaGenerator::NfaNodeId NfaGenerator::EmplaceNode() {
+  assert(nodes_.size() < UINT32_MAX);
+  const uint32_t index = static_cast<uint32_t>(nodes_.size());
+  nodes_.emplace_back();
+  merge_parents_.push_back(index);
+  tail_data_indexes_.push_back(kNoTailNodeData);
+  return NfaNodeId(index);
 }
 
 bool NfaGenerator::NfaNode::MergeNodes(NfaNode* node_src) {
@@ -118,23 +551,32 @@ bool NfaGenerator::NfaNode::MergeNodes(NfaNode* node_src) {
   if (GetConditionalTransfers().size() != 0 &&
       node_src->GetConditionalTransfers().size() != 0) {
     for (const auto& transform : node_src->GetConditionalTransfers()) {
-      NfaNodeId next_node_id = GetForwardNodeId(transform.first);
-      if (!next_node_id.IsValid() && next_node_id != transform.second) {
+      NfaNodeId next_node_id =
+          GetForwardNodeId(static_cast<char>(transform.low));
+      if (!next_node_id.IsValid() && next_node_id != transform.next_node_id) {
         return false;
       }
     }
   }
-  nodes_forward_.merge(node_src->nodes_forward_);
-  conditionless_transfer_nodes_id.merge(
-      node_src->conditionless_transfer_nodes_id);
+  // 与this中已存在的转移条件冲突的部分保留this中的条目
+  for (const auto& transform : node_src->GetConditionalTransfers()) {
+    InsertConditionTransferRange(transform.low, transform.high,
+                                 transform.next_node_id);
+  }
+  node_src->nodes_forward_.clear();
+  for (NfaNodeId node_id : node_src->conditionless_transfer_nodes_id) {
+    AddNoconditionTransfer(node_id);
+  }
+  node_src->conditionless_transfer_nodes_id.clear();
   return true;
 }
 
 inline const NfaGenerator::TailNodeData& NfaGenerator::GetTailNodeData(
     NfaNodeId node_id) {
-  auto iter = tail_nodes_.find(node_id);
-  if (iter != tail_nodes_.end()) [[likely]] {
-    return iter->second;
+  const uint32_t tail_data_index =
+      tail_data_indexes_[FindRepresentative(node_id)];
+  if (tail_data_index != kNoTailNodeData) [[likely]] {
+    return tail_datas_[tail_data_index];
   } else {
     return kNotTailNodeTag;
   }
@@ -144,7 +586,13 @@ NfaGenerator::RegexConstruct(TailNodeData&& tail_node_data,
                              const std::string& raw_regex_string,
                              size_t&& next_character_index,
                              const bool add_to_nfa_head) {
-  NfaNodeId head_id = node_manager_.EmplaceObject();
+#ifdef USE_GLUSHKOV_NFA_CONSTRUCT
+  if (add_to_nfa_head) {
+    return GlushkovConstruct(std::move(tail_node_data), raw_regex_string,
+                             &next_character_index);
+  }
+#endif  // USE_GLUSHKOV_NFA_CONSTRUCT
+  NfaNodeId head_id = EmplaceNode();
   NfaNodeId tail_id = head_id;
   NfaNodeId pre_tail_id = head_id;
   if (next_character_index >= raw_regex_string.size()) [[unlikely]] {
@@ -213,21 +661,18 @@ NfaGenerator::RegexConstruct(TailNodeData&& tail_node_data,
         c_now = raw_regex_string[next_character_index];
         ++next_character_index;
         pre_tail_id = tail_id;
-        tail_id = node_manager_.EmplaceObject();
+        tail_id = EmplaceNode();
         GetNfaNode(pre_tail_id).SetConditionTransfer(c_now, tail_id);
         break;
       case '.':  // 仅对单个字符生效
         pre_tail_id = tail_id;
-        tail_id = node_manager_.EmplaceObject();
-        for (char transform_char = CHAR_MIN; transform_char != CHAR_MAX;
-             ++transform_char) {
-          GetNfaNode(pre_tail_id).SetConditionTransfer(transform_char, tail_id);
-        }
-        GetNfaNode(pre_tail_id).SetConditionTransfer(CHAR_MAX, tail_id);
+        tail_id = EmplaceNode();
+        GetNfaNode(pre_tail_id)
+            .SetConditionTransferRange(CHAR_MIN, CHAR_MAX, tail_id);
         break;
       default:
         pre_tail_id = tail_id;
-        tail_id = node_manager_.EmplaceObject();
+        tail_id = EmplaceNode();
         GetNfaNode(pre_tail_id).SetConditionTransfer(c_now, tail_id);
         break;
     }
@@ -238,7 +683,11 @@ NfaGenerator::RegexConstruct(TailNodeData&& tail_node_data,
       SetTailNode(tail_id, std::move(tail_node_data));
     }
   } else {
-    node_manager_.RemoveObject(head_id);
+    // 未添加任何字符，head_id为最后创建的节点，直接删除
+    assert(head_id.GetRawValue() + 1 == nodes_.size());
+    nodes_.pop_back();
+    merge_parents_.pop_back();
+    tail_data_indexes_.pop_back();
     head_id = tail_id = NfaNodeId::InvalidId();
   }
   return std::make_pair(head_id, tail_id);
@@ -248,92 +697,95 @@ std::pair<NfaGenerator::NfaNodeId, NfaGenerator::NfaNodeId>
 NfaGenerator::WordConstruct(const std::string& str,
                             TailNodeData&& word_attached_data) {
   assert(str.size() != 0);
-  NfaNodeId head_id = node_manager_.EmplaceObject();
+#ifdef USE_GLUSHKOV_NFA_CONSTRUCT
+  // 头结点直接条件转移到第一个字符后的节点，不使用无条件转移
+  NfaNodeId head_id = head_node_id_;
+  NfaNodeId tail_id = EmplaceNode();
+  uint8_t first_character = static_cast<uint8_t>(str.front());
+  GetNfaNode(head_id).AddOverlappingConditionTransferRange(
+      first_character, first_character, tail_id);
+  for (auto iter = std::next(str.begin()); iter != str.end(); ++iter) {
+    NfaNodeId temp_id = EmplaceNode();
+    GetNfaNode(tail_id).SetConditionTransfer(*iter, temp_id);
+    tail_id = temp_id;
+  }
+#else
+  NfaNodeId head_id = EmplaceNode();
   NfaNodeId tail_id = head_id;
   for (auto c : str) {
-    NfaNodeId temp_id = node_manager_.EmplaceObject();
+    NfaNodeId temp_id = EmplaceNode();
     GetNfaNode(tail_id).SetConditionTransfer(c, temp_id);
     tail_id = temp_id;
   }
   GetNfaNode(head_node_id_).AddNoconditionTransfer(head_id);
+#endif  // USE_GLUSHKOV_NFA_CONSTRUCT
   SetTailNode(tail_id, std::move(word_attached_data));
   return std::make_pair(head_id, tail_id);
 }
 
 void NfaGenerator::MergeOptimization() {
-  node_manager_.SetAllObjectsCanBeSourceInMerge();
+#ifdef USE_GLUSHKOV_NFA_CONSTRUCT
+  // Glushkov构造不生成无条件转移，没有可以合并的节点
+#else
+  // 每个代表节点是否可以作为合并的源节点
+  std::vector<bool> can_be_source_in_merge(nodes_.size(), true);
   std::queue<NfaNodeId> q;
   q.push(GetHeadNfaNodeId());
   while (!q.empty()) {
-    NfaNodeId id_now = q.front();
+    NfaNodeId id_now(FindRepresentative(q.front()));
     NfaNode& node_now = GetNfaNode(id_now);
     q.pop();
-    if (!node_manager_.CanBeSourceInMerge(id_now)) {
+    if (!can_be_source_in_merge[id_now]) {
       continue;
     }
     // 检查每一个与当前处理节点等价的节点（就是当前节点可以无条件转移到的节点）
     // 如果当前节点转移表中的项在等价节点中存在则可以从当前节点转移表中删除
-    for (auto equal_node_id :
-         GetNfaNode(id_now).GetUnconditionTransferNodesIds()) {
-      if (equal_node_id == id_now) [[unlikely]] {
+    // 遍历过程中会移除无条件转移，因此遍历副本
+    const std::vector<NfaNodeId> equal_node_ids =
+        node_now.GetUnconditionTransferNodesIds();
+    for (auto equal_node_id : equal_node_ids) {
+      if (FindRepresentative(equal_node_id) == id_now) [[unlikely]] {
         // 跳过转移到自己的情况
         continue;
       }
+      const auto& unconditional_transfer_node_ids =
+          node_now.GetUnconditionTransferNodesIds();
+      if (std::find(unconditional_transfer_node_ids.begin(),
+                    unconditional_transfer_node_ids.end(),
+                    equal_node_id) == unconditional_transfer_node_ids.end()) {
+        // 已经因为可以从其它等价节点转移到而被移除，如果继续移除该节点可以
+        // 转移到的节点，那么两个互相无条件转移的节点会同时被移除
+        continue;
+      }
       auto& equal_node = GetNfaNode(equal_node_id);
       // 处理无条件转移表
-      const auto& equal_node_unconditional_transfer_node_ids =
-          equal_node.GetUnconditionTransferNodesIds();
-      for (auto iter = node_now.GetUnconditionTransferNodesIds().cbegin();
-           iter != node_now.GetUnconditionTransferNodesIds().cend();) {
-        if (equal_node_unconditional_transfer_node_ids.find(*iter) !=
-            equal_node_unconditional_transfer_node_ids.end()) {
-          // 当前节点转移表中的项在等价节点中存在
-          // 移除该项
-          if (*iter != equal_node_id) [[likely]] {
-            // 如果存在等价节点的无条件自环节点则不能移除
-            // 否则会失去指向等价节点的记录，导致正则不完整、内存泄漏等
-            ++iter;
-            node_now.RemoveConditionlessTransfer(*iter);
-            // continue防止额外前移iter
-            continue;
-          }
+      // 当前节点转移表中的项在等价节点中存在则移除该项
+      // 如果存在等价节点的无条件自环节点则不能移除，否则会失去指向等价节点的记录
+      for (auto node_id : equal_node.GetUnconditionTransferNodesIds()) {
+        if (node_id != equal_node_id) [[likely]] {
+          node_now.RemoveConditionlessTransfer(node_id);
         }
-        ++iter;
       }
       // 处理条件转移表
-      const auto& equal_node_conditional_transfers =
-          equal_node.GetConditionalTransfers();
-      for (auto iter = node_now.GetConditionalTransfers().cbegin();
-           iter != node_now.GetConditionalTransfers().cend();) {
-        auto equal_node_iter =
-            equal_node_conditional_transfers.find(iter->first);
-        if (equal_node_iter != equal_node_conditional_transfers.cend() &&
-            iter->second == equal_node_iter->second) {
-          // 当前节点转移表中的项在等价节点中存在
-          // 移除该项
-          ++iter;
-          node_now.RemoveConditionalTransfer(iter->first);
-          // continue防止额外前移iter
-          continue;
-        }
-        ++iter;
-      }
+      // 当前节点转移表中的项在等价节点中存在则移除该项
+      node_now.RemoveConditionalTransfersSameAs(equal_node);
       // 压入等效节点等待处理
       q.push(equal_node_id);
       // 压入当前节点的所有可以条件转移到的节点等待处理
       for (const auto& conditional_transfer :
            node_now.GetConditionalTransfers()) {
-        q.push(conditional_transfer.second);
+        q.push(conditional_transfer.next_node_id);
       }
     }
     // 检查是否可以将node_now与node_now唯一可无条件转移到的节点合并
     if (node_now.GetConditionalTransfers().empty() &&
         node_now.GetUnconditionTransferNodesIds().size() == 1) [[unlikely]] {
       // 只剩一条无条件转移路径，该节点可以与无条件转移到的节点合并
-      NfaNodeId dst_node_id =
-          *node_now.GetUnconditionTransferNodesIds().cbegin();
+      NfaNodeId dst_node_id(
+          FindRepresentative(node_now.GetUnconditionTransferNodesIds().front()));
       const NfaGenerator::TailNodeData& dst_tag = GetTailNodeData(dst_node_id);
-      const NfaGenerator::TailNodeData& src_tag = GetTailNodeData(id_now);
+      // 设置尾节点时可能移动尾节点数据，因此复制源节点的尾节点数据
+      const NfaGenerator::TailNodeData src_tag = GetTailNodeData(id_now);
       if (dst_tag != NfaGenerator::kNotTailNodeTag &&
           src_tag != NfaGenerator::kNotTailNodeTag &&
           dst_tag.second == src_tag.second && dst_tag.first != src_tag.first) {
@@ -341,96 +793,140 @@ void NfaGenerator::MergeOptimization() {
                   std::format("两个尾节点具有相同优先级且不对应同一个节点"))
         exit(-1);
       }
-      bool result = GetNfaNode(dst_node_id).MergeNodes(&GetNfaNode(id_now));
+      bool result = GetNfaNode(dst_node_id).MergeNodes(&node_now);
       if (result) {
         if (src_tag != NfaGenerator::kNotTailNodeTag) {
           SetTailNode(dst_node_id, src_tag);
           RemoveTailNode(id_now);
         }
-        bool result = node_manager_.MergeObjects(
-            dst_node_id, id_now,
-            [](NfaNode&, NfaNode&) -> bool { return true; });
-        assert(result);
+        // 之后所有指向id_now的ID都通过并查集找到dst_node_id
+        merge_parents_[id_now] = dst_node_id.GetRawValue();
       }
-
     } else {
       // 没有执行任何操作，不存在从该节点开始的合并操作
       // 设置该节点在合并时不能作为源节点
-      node_manager_.SetObjectCanNotBeSourceInMerge(id_now);
+      can_be_source_in_merge[id_now] = false;
     }
   }
+#endif  // USE_GLUSHKOV_NFA_CONSTRUCT
+  EdgeArrayConstruct();
 }
 
-// @brief 添加尾节点信息
+NfaGenerator::NfaSize NfaGenerator::GetNfaSize() const {
+  NfaSize nfa_size;
+  for (uint32_t index = 0; index < nodes_.size(); index++) {
+    if (merge_parents_[index] == index) {
+      const NfaNode& node = nodes_[index];
+      ++nfa_size.node_num;
+      nfa_size.conditional_transfer_num +=
+          node.GetConditionalTransfers().size();
+      nfa_size.conditionless_transfer_num +=
+          node.GetUnconditionTransferNodesIds().size();
+    }
+  }
+  return nfa_size;
+}
+
+void NfaGenerator::EdgeArrayConstruct() {
+  edge_array_ = EdgeArray();
+  edge_array_.conditionless_offsets.reserve(nodes_.size() + 1);
+  edge_array_.conditional_offsets.reserve(nodes_.size() + 1);
+  edge_array_.conditionless_offsets.push_back(0);
+  edge_array_.conditional_offsets.push_back(0);
+  for (uint32_t index = 0; index < nodes_.size(); index++) {
+    if (merge_parents_[index] == index) {
+      // 只存储代表节点的转移，转移到的节点替换为代表节点
+      const NfaNode& node = nodes_[index];
+      const size_t conditionless_begin =
+          edge_array_.conditionless_targets.size();
+      for (NfaNodeId node_id : node.GetUnconditionTransferNodesIds()) {
+        NfaNodeId target_id(FindRepresentative(node_id));
+        if (std::find(edge_array_.conditionless_targets.begin() +
+                          conditionless_begin,
+                      edge_array_.conditionless_targets.end(),
+                      target_id) == edge_array_.conditionless_targets.end()) {
+          edge_array_.conditionless_targets.push_back(target_id);
+        }
+      }
+      for (const auto& transfer : node.GetConditionalTransfers()) {
+        edge_array_.conditional_transfers.push_back(
+            NfaNode::ConditionalTransferRange{
+                transfer.low, transfer.high,
+                NfaNodeId(FindRepresentative(transfer.next_node_id))});
+      }
+    }
+    edge_array_.conditionless_offsets.push_back(
+        static_cast<uint32_t>(edge_array_.conditionless_targets.size()));
+    edge_array_.conditional_offsets.push_back(
+        static_cast<uint32_t>(edge_array_.conditional_transfers.size()));
+  }
+  closure_marks_.assign(nodes_.size(), 0);
+  closure_mark_generation_ = 0;
+}
 
 std::pair<NfaGenerator::NfaNodeId, NfaGenerator::NfaNodeId>
 NfaGenerator::CreateSwitchTree(const std::string& raw_regex_string,
                                size_t* const next_character_index) {
-  NfaNodeId head_id = node_manager_.EmplaceObject();
-  NfaNodeId tail_id = node_manager_.EmplaceObject();
+  auto ranges = CharacterClassParse(raw_regex_string, next_character_index);
+  NfaNodeId head_id = EmplaceNode();
+  NfaNodeId tail_id = EmplaceNode();
   NfaNode& head_node = GetNfaNode(head_id);
-  char character_pre;
-  // 初始化成不是']'的值从而可以进入循环
-  char character_now = '[';
-  while (character_now != ']') {
-    if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
-      LOG_ERROR("NFA Generator",
-                std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
-                            *next_character_index + 9))
-      exit(-1);
-    }
-    character_pre = character_now;
-    character_now = raw_regex_string[*next_character_index];
-    ++*next_character_index;
-    switch (character_now) {
-      case '-': {
-        // 读入另一端的字符
-        if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
-          LOG_ERROR("NFA Generator",
-                    std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
-                                *next_character_index + 9))
-          exit(-1);
-        }
-        character_now = raw_regex_string[*next_character_index];
-        ++*next_character_index;
-        if (character_now == ']') [[unlikely]] {
-          // [+-]这种正则表达式
-          break;
-        }
-        char bigger_character = std::max(character_now, character_pre);
-        for (char smaller_character = std::min(character_pre, character_now);
-             smaller_character < bigger_character; smaller_character++) {
-          head_node.SetConditionTransfer(smaller_character, tail_id);
-        }
-        // 防止bigger_character == CHAR_MAX导致回环，无法退出上面循环
-        head_node.SetConditionTransfer(bigger_character, tail_id);
-      } break;
-      case '\\':
-        if (*next_character_index >= raw_regex_string.size()) [[unlikely]] {
-          LOG_ERROR("NFA Generator",
-                    std::format("非法正则 {:}\n{: >{}}", raw_regex_string, '^',
-                                *next_character_index + 9))
-          exit(-1);
-        }
-        character_now = raw_regex_string[*next_character_index];
-        ++*next_character_index;
-        head_node.SetConditionTransfer(character_now, tail_id);
-        break;
-      case ']':
-        break;
-      default:
-        head_node.SetConditionTransfer(character_now, tail_id);
-        break;
-    }
+  for (auto [c_low, c_high] : ranges) {
+    head_node.SetConditionTransferRange(c_low, c_high, tail_id);
   }
-  if (head_node.GetConditionalTransfers().empty()) [[unlikely]] {
-    node_manager_.RemoveObject(head_id);
+  return std::make_pair(head_id, tail_id);
+}
+
+std::pair<NfaGenerator::NfaNodeId, NfaGenerator::NfaNodeId>
+NfaGenerator::GlushkovConstruct(TailNodeData&& tail_node_data,
+                                const std::string& raw_regex_string,
+                                size_t* const next_character_index) {
+  std::vector<RegexAstNode> ast;
+  size_t root = RegexParse(raw_regex_string, next_character_index, &ast);
+  // 所有位置对应的kCharSet节点在ast中的下标
+  std::vector<size_t> positions;
+  // 每个位置后可以跟随的位置
+  std::vector<std::vector<size_t>> follow;
+  GlushkovAttributes root_attributes =
+      GlushkovAnalyze(ast, root, &positions, &follow);
+  if (positions.empty()) [[unlikely]] {
+    return std::make_pair(NfaNodeId::InvalidId(), NfaNodeId::InvalidId());
+  }
+  if (root_attributes.nullable) [[unlikely]] {
     LOG_ERROR("NFA Generator",
-              std::format("非法正则 {:}\n{: >{}}\n[]中为空", raw_regex_string,
-                          '^', *next_character_index + 9))
+              std::format("非法正则 {:}\n正则可以匹配空串", raw_regex_string))
     exit(-1);
   }
-  return std::make_pair(head_id, tail_id);
+  // 每个位置对应一个NFA节点，移入该位置的字符后到达该节点
+  std::vector<NfaNodeId> position_nodes(positions.size());
+  for (auto& position_node : position_nodes) {
+    position_node = EmplaceNode();
+  }
+  auto add_transfers = [&](NfaNodeId node_src,
+                           const std::vector<size_t>& positions_dst) {
+    NfaNode& node = GetNfaNode(node_src);
+    for (size_t position : positions_dst) {
+      for (auto [low, high] : ast[positions[position]].ranges) {
+        node.AddOverlappingConditionTransferRange(low, high,
+                                                  position_nodes[position]);
+      }
+    }
+  };
+  // NFA头结点直接条件转移到可以作为第一个字符的位置，不使用无条件转移
+  add_transfers(head_node_id_, root_attributes.first);
+  for (size_t position = 0; position < positions.size(); position++) {
+    auto& follow_positions = follow[position];
+    std::sort(follow_positions.begin(), follow_positions.end());
+    follow_positions.erase(
+        std::unique(follow_positions.begin(), follow_positions.end()),
+        follow_positions.end());
+    add_transfers(position_nodes[position], follow_positions);
+  }
+  for (size_t position : root_attributes.last) {
+    SetTailNode(position_nodes[position], tail_node_data);
+  }
+  return std::make_pair(head_node_id_,
+                        position_nodes[root_attributes.last.back()]);
 }
 
 const NfaGenerator::TailNodeData NfaGenerator::kNotTailNodeTag =
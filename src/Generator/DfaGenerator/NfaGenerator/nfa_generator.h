@@ -4,19 +4,20 @@
 /// NFA Generator将输入的正则表达式转化为正则数据结构
 /// 支持使用char的全部字符
 /// 支持基础的正则格式有：单字符，[]，[]内使用-，()，*，+，?
+/// 默认使用Thompson构造；定义USE_GLUSHKOV_NFA_CONSTRUCT时先将正则解析为语法树，
+/// 然后生成不含无条件转移的位置自动机（Glushkov构造），Closure只返回节点自身
+/// 所有节点连续存储在一个数组中，使用32位下标作为节点ID；合并的节点通过并查集
+/// 记录；MergeOptimization后所有转移按CSR格式存储在连续的数组中
 
 #ifndef GENERATOR_DFAGENERATOR_NFAGENERATOR_NFAGENERATOR_H_
 #define GENERATOR_DFAGENERATOR_NFAGENERATOR_NFAGENERATOR_H_
 
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
+#include <span>
 #include <vector>
 
 #include "Common/common.h"
 #include "Common/id_wrapper.h"
-#include "Common/multimap_object_manager.h"
-#include "Common/unordered_struct_manager.h"
 #include "Generator/export_types.h"
 
 namespace frontend::generator::dfa_generator::nfa_generator {
@@ -30,8 +31,11 @@ class NfaGenerator {
   class NfaNode;
 
  public:
-  /// @brief NfaNode在管理类中的ID
-  using NfaNodeId = frontend::common::MultimapObjectManager<NfaNode>::ObjectId;
+  /// @brief 用来生成NfaNodeId的枚举
+  enum class WrapperLabel { kNfaNodeId };
+  /// @brief NFA节点ID，值为节点在nodes_中的下标
+  using NfaNodeId = frontend::common::ExplicitIdWrapper<uint32_t, WrapperLabel,
+                                                        WrapperLabel::kNfaNodeId>;
 
   /// @brief 尾节点数据，内容为该单词所附带的属性
   /// @details 前半部分为用户定义数据，后半部分为单词优先级，数字越大优先级越高
@@ -41,7 +45,7 @@ class NfaGenerator {
   /// @class NfaNode nfa_generator.h
   /// @brief 表示正则的Nfa节点
   /// @details
-  /// 1.NFA以链表的形式存储在内存中，每个节点具有两个成员，分别存储从该节点可以无条件
+  /// 1.NFA节点连续存储在数组中，每个节点具有两个成员，分别存储从该节点可以无条件
   /// 转移到的节点和移入某个字符后转移到的节点。
   /// 2.从一个节点可以无条件转移到的所有节点都与该节点等价，无论是可以从该节点直接无
   /// 条件转移还是间接无条件转移得到。
@@ -61,8 +65,19 @@ class NfaGenerator {
   /// 节点的节点的无条件转移表，这样就需要追踪整个添加过程，大大增加复杂度
   /// 6.尾节点是携带有效返回数据（WordAttachedData）的节点，在状态转移到该节点后如果
   /// 终止转换过程，则获取到有效的单词（已经注册过的单词）。
+  /// 7.条件转移按字符范围存储，.和[]只生成少量条目而不是每个字符一个条目
   class NfaNode {
    public:
+    /// @brief 条件转移条目，移入[low, high]内的字符后转移到next_node_id
+    /// @note low和high为字符转换为uint8_t后的值，同一节点的条目按low升序存储
+    /// Thompson构造下条目互不重叠，相邻且转移到同一节点的条目会被合并；
+    /// Glushkov构造下条目可以重叠，表示一个字符下可以转移到多个节点
+    struct ConditionalTransferRange {
+      uint8_t low;
+      uint8_t high;
+      NfaNodeId next_node_id;
+    };
+
     NfaNode() {}
     NfaNode(const NfaNode& node)
         : nodes_forward_(node.nodes_forward_),
@@ -75,34 +90,52 @@ class NfaGenerator {
 
     /// @brief 根据要移入的字母获取转移到的下一个节点ID
     /// @param[in] c_transfer ：要移入的字母
-    /// @return 转移到的下一个节点ID
+    /// @return 转移到的下一个节点ID，存在多个时返回其中一个
     /// @retval NfaNodeId::InvalidId() ：该节点不能移入给定字母
-    NfaNodeId GetForwardNodeId(char c_transfer);
+    NfaNodeId GetForwardNodeId(char c_transfer) const;
     /// @brief 获取所有可以无条件转移到的节点ID
-    /// @return 可以无条件转移到的节点ID的集合
-    const std::unordered_set<NfaNodeId>& GetUnconditionTransferNodesIds()
-        const {
+    /// @return 可以无条件转移到的节点ID，不含重复ID
+    /// @note 节点合并后其中的ID可能不是代表节点的ID
+    const std::vector<NfaNodeId>& GetUnconditionTransferNodesIds() const {
       return conditionless_transfer_nodes_id;
     }
     /// @brief 获取该节点全部转移条件和在转移条件下可以转移到的节点ID
-    const std::unordered_map<char, NfaNodeId>& GetConditionalTransfers() const {
+    /// @return 返回按字符范围存储的条件转移条目，按low升序排列
+    const std::vector<ConditionalTransferRange>& GetConditionalTransfers()
+        const {
       return nodes_forward_;
     }
     /// @brief 设置条件转移条目
     /// @param[in] c_transfer ：转移条件（要移入的字符）
     /// @param[out] node_id ：转移后到达的节点ID
-    /// @note 会覆盖原来的转移条件（如果存在）
-    void SetConditionTransfer(char c_transfer, NfaNodeId node_id);
+    /// @note 已存在的转移条件必须转移到相同节点
+    void SetConditionTransfer(char c_transfer, NfaNodeId node_id) {
+      SetConditionTransferRange(c_transfer, c_transfer, node_id);
+    }
+    /// @brief 设置一段字符范围的条件转移条目
+    /// @param[in] c_low ：转移条件范围下界（包含）
+    /// @param[in] c_high ：转移条件范围上界（包含）
+    /// @param[in] node_id ：转移后到达的节点ID
+    /// @details
+    /// c_low和c_high按char比较，跨越0的范围会拆分成两个条目存储
+    /// @note 范围内已存在的转移条件必须转移到相同节点
+    void SetConditionTransferRange(char c_low, char c_high, NfaNodeId node_id);
+    /// @brief 添加一段字符范围的条件转移条目，允许与已有条目重叠
+    /// @param[in] low ：转移条件范围下界（包含，转换为uint8_t后的值）
+    /// @param[in] high ：转移条件范围上界（包含，转换为uint8_t后的值）
+    /// @param[in] node_id ：转移后到达的节点ID
+    /// @note 用于Glushkov构造，一个字符下可以转移到多个节点
+    void AddOverlappingConditionTransferRange(uint8_t low, uint8_t high,
+                                              NfaNodeId node_id);
     /// @brief 添加无条件转移节点
     /// @param[in] node_id ：无条件转移到的节点ID
     /// @note node_id可以已经添加过
     void AddNoconditionTransfer(NfaNodeId node_id);
-    /// @brief 移除一条转移条目
-    /// @param[in] c_transfer ：要移除的转移条目的转移条件
-    /// @return 返回移除的条目数目
-    /// @retval 0 ：没有条目被移除
-    /// @retval 1 ：移除了一条转移条目
-    size_t RemoveConditionalTransfer(char c_transfer);
+    /// @brief 移除在另一个节点中存在相同条件和相同目标的转移条件
+    /// @param[in] node ：用来比较的节点
+    /// @return 返回移除的转移条件（字符）数目
+    /// @note node与this相同时不移除任何条目
+    size_t RemoveConditionalTransfersSameAs(const NfaNode& node);
     /// @brief 移除一个无条件转移节点
     /// @param[in] node_id ：要移除的转移到的节点ID
     /// @return 返回移除的条目数目
@@ -125,13 +158,47 @@ class NfaGenerator {
     bool MergeNodes(NfaNode* node_src);
 
    private:
+    /// @brief 插入一段字符范围的条件转移条目，仅填充尚未存在转移条件的字符
+    /// @param[in] low ：转移条件范围下界（包含）
+    /// @param[in] high ：转移条件范围上界（包含）
+    /// @param[in] node_id ：转移后到达的节点ID
+    /// @return 返回范围内已存在的转移条件是否都转移到node_id
+    bool InsertConditionTransferRange(uint8_t low, uint8_t high,
+                                      NfaNodeId node_id);
+
     /// @brief 记录转移条件与转移到的节点，一个条件仅允许对应一个节点
-    std::unordered_map<char, NfaNodeId> nodes_forward_;
+    std::vector<ConditionalTransferRange> nodes_forward_;
     /// @brief 存储无条件转移节点
-    std::unordered_set<NfaNodeId> conditionless_transfer_nodes_id;
+    /// @note 每个节点的无条件转移很少，使用数组存储并在添加时去重
+    std::vector<NfaNodeId> conditionless_transfer_nodes_id;
+  };
+
+  /// @class EdgeArray nfa_generator.h
+  /// @brief 按CSR格式连续存储的所有节点的转移
+  /// @details
+  /// 1.节点i的无条件转移存储在conditionless_targets的
+  /// [conditionless_offsets[i], conditionless_offsets[i+1])中，条件转移同理
+  /// 2.转移到的节点均为并查集中的代表节点，已被合并的节点不存储任何转移
+  /// @note 在MergeOptimization的最后构建，之后不再修改NFA
+  struct EdgeArray {
+    std::vector<uint32_t> conditionless_offsets;
+    std::vector<NfaNodeId> conditionless_targets;
+    std::vector<uint32_t> conditional_offsets;
+    std::vector<NfaNode::ConditionalTransferRange> conditional_transfers;
   };
 
  public:
+  /// @class NfaSize nfa_generator.h
+  /// @brief NFA的规模，只统计并查集中的代表节点
+  struct NfaSize {
+    /// @brief 节点数目
+    size_t node_num = 0;
+    /// @brief 条件转移条目数目，每个条目表示一段字符范围
+    size_t conditional_transfer_num = 0;
+    /// @brief 无条件转移数目
+    size_t conditionless_transfer_num = 0;
+  };
+
   NfaGenerator() {}
   NfaGenerator(const NfaGenerator&) = delete;
   NfaGenerator(NfaGenerator&&) = delete;
@@ -146,10 +213,31 @@ class NfaGenerator {
   const TailNodeData& GetTailNodeData(NfaNodeId node_id);
   /// @brief 根据NFA节点ID获取NFA节点
   /// @param[in] node_id ：NFA节点ID
-  /// @return 返回获取到的NFA节点
+  /// @return 返回获取到的NFA节点，节点已被合并时返回合并到的节点
   /// @attention node_id必须对应已存在的NFA节点
+  /// 添加节点后之前获取的引用失效
   NfaNode& GetNfaNode(NfaNodeId node_id) {
-    return node_manager_.GetObject(node_id);
+    return nodes_[FindRepresentative(node_id)];
+  }
+  /// @brief 获取NFA节点数目
+  /// @return 返回NFA节点数目（包括已被合并的节点）
+  /// @note 所有NfaNodeId的值都小于节点数目
+  size_t GetNodeNum() const { return nodes_.size(); }
+  /// @brief 获取NFA的规模
+  /// @return 返回代表节点数目和它们的转移数目
+  /// @note 可以在MergeOptimization前后调用以比较合并优化的效果
+  NfaSize GetNfaSize() const;
+  /// @brief 获取节点的所有条件转移
+  /// @param[in] node_id ：NFA节点ID
+  /// @return 返回按low升序排列的条件转移条目，转移到的节点均为代表节点
+  /// @note 该函数在MergeOptimization后调用
+  std::span<const NfaNode::ConditionalTransferRange> GetConditionalTransfers(
+      NfaNodeId node_id) {
+    const uint32_t index = FindRepresentative(node_id);
+    return std::span(edge_array_.conditional_transfers)
+        .subspan(edge_array_.conditional_offsets[index],
+                 edge_array_.conditional_offsets[index + 1] -
+                     edge_array_.conditional_offsets[index]);
   }
   /// @brief 解析正则
   /// @param[in] tail_node_data ：获取到该单词时返回的数据
@@ -169,6 +257,8 @@ class NfaGenerator {
   /// 如果遇到')'，返回时不自动处理')'后的范围限制符号（?、+、*等）
   /// @note 返回时next_character_index指向下一个要读取的字符
   /// add_to_nfa_head == false时tail_node_data可以提供任意参数
+  /// 定义USE_GLUSHKOV_NFA_CONSTRUCT时add_to_nfa_head == true则使用
+  /// GlushkovConstruct构造，返回值见GlushkovConstruct
   /// @attention 如果next_character_index >= raw_regex_string.size()
   /// 则返回值两部分都为NfaNodeId::InvalidId()
   std::pair<NfaNodeId, NfaNodeId> RegexConstruct(
@@ -188,25 +278,27 @@ class NfaGenerator {
   /// 合并优化由两部分组成，一部分为删除当前处理节点与等效节点重复的转移项
   /// 另一部分为当前处理节点仅存在无条件转移到等效节点的转移条目时合并两个节点
   /// 直接使用NFA也可以降低成本
+  /// 最后将所有转移按CSR格式存储到edge_array_中，之后不能再添加正则
   void MergeOptimization();
 
   /// @brief 获取给定NFA节点的所有等效节点ID（包含自身）
   /// @param[in] node_id ：要获取所有等效节点的NFA节点ID
-  /// @return 前半部分为所有等效节点的集合，后半部分为这些等效节点代表的单词的
-  /// 附属数据
+  /// @return 前半部分为所有等效节点的代表节点ID，按广度优先顺序排列且不重复，
+  /// 后半部分为这些等效节点代表的单词的附属数据
   /// @note 返回值后半部分为所有可能代表的单词中最高优先级的单词的数据
   /// 如果所有等效节点都无法代表任何单词，那么后半部分返回kNotTailNodeTag
-  std::pair<std::unordered_set<NfaNodeId>, TailNodeData> Closure(
-      NfaNodeId node_id);
+  /// 该函数在MergeOptimization后调用
+  std::pair<std::vector<NfaNodeId>, TailNodeData> Closure(NfaNodeId node_id);
   /// @brief 获取给定NFA节点在转移条件下可以到达的等效节点
   /// @param[in] id_src ：源节点
   /// @param[in] c_transform ：转移条件
   /// @return 前半部分为所有等效节点的集合，后半部分为这些等效节点代表的单词的
   /// 附属数据
   /// @details
-  /// 该函数获取转移后达到的NfaNodeId，然后返回该ID的Closure结果
-  std::pair<std::unordered_set<NfaNodeId>, TailNodeData> Goto(NfaNodeId id_src,
-                                                              char c_transform);
+  /// 该函数获取转移后达到的所有NfaNodeId，然后返回这些ID的Closure结果的并集
+  /// @note 该函数在MergeOptimization后调用
+  std::pair<std::vector<NfaNodeId>, TailNodeData> Goto(NfaNodeId id_src,
+                                                       char c_transform);
   /// @brief NFA初始化
   /// @note 可以通过调用该函数清空已有的NFA配置
   void NfaInit();
@@ -215,13 +307,41 @@ class NfaGenerator {
   static const TailNodeData kNotTailNodeTag;
 
  private:
+  /// @brief 表示节点不是尾节点的尾节点数据下标
+  static constexpr uint32_t kNoTailNodeData = UINT32_MAX;
+
+  /// @brief 创建节点
+  /// @return 返回新节点的ID
+  /// @note 添加节点后之前获取的NfaNode引用失效
+  NfaNodeId EmplaceNode();
+  /// @brief 查找节点所在的并查集的代表节点
+  /// @param[in] node_id ：NFA节点ID
+  /// @return 返回代表节点的下标，节点未被合并时返回节点自身的下标
+  /// @note 查找时压缩路径
+  uint32_t FindRepresentative(NfaNodeId node_id) {
+    uint32_t index = node_id.GetRawValue();
+    while (merge_parents_[index] != index) {
+      merge_parents_[index] = merge_parents_[merge_parents_[index]];
+      index = merge_parents_[index];
+    }
+    return index;
+  }
+  /// @brief 按CSR格式存储所有代表节点的转移
+  /// @note 该函数填写edge_array_
+  void EdgeArrayConstruct();
   /// @brief 移除尾节点信息
   /// @param[in] tail_node_id ：要移除尾节点信息的节点ID
   /// @return 返回删除的条目个数
   /// @retval 0 ：未删除任何条目（node_id指定的节点不存在或不为尾节点）
   /// @retval 1 ：删除了已有的一个条目
   size_t RemoveTailNode(NfaNodeId tail_node_id) {
-    return tail_nodes_.erase(tail_node_id);
+    uint32_t& tail_data_index =
+        tail_data_indexes_[FindRepresentative(tail_node_id)];
+    if (tail_data_index == kNoTailNodeData) {
+      return 0;
+    }
+    tail_data_index = kNoTailNodeData;
+    return 1;
   }
   /// @brief 设置尾节点信息
   /// @tparam TailNodeDataType ：尾节点数据类型，仅支持const
@@ -234,9 +354,13 @@ class NfaGenerator {
   /// 已存在node_id的尾节点记录，需要先调用RemoveTailNode然后再调用该函数
   template <class TailNodeDataType>
   bool SetTailNode(NfaNodeId node_id, TailNodeDataType&& tail_node_data) {
-    return tail_nodes_
-        .emplace(node_id, std::forward<TailNodeDataType>(tail_node_data))
-        .second;
+    uint32_t& tail_data_index = tail_data_indexes_[FindRepresentative(node_id)];
+    if (tail_data_index != kNoTailNodeData) {
+      return false;
+    }
+    tail_data_index = static_cast<uint32_t>(tail_datas_.size());
+    tail_datas_.emplace_back(std::forward<TailNodeDataType>(tail_node_data));
+    return true;
   }
   /// @brief 根据输入生成可选字符结构
   /// @param[in] raw_regex_string ：表示单词的正则表达式字符串
@@ -251,13 +375,39 @@ class NfaGenerator {
   /// 4.例：raw_regex_string == "[a-zA-Z_]" next_character_index == 1
   std::pair<NfaNodeId, NfaNodeId> CreateSwitchTree(
       const std::string& raw_regex_string, size_t* const next_character_index);
+  /// @brief 使用Glushkov构造添加正则
+  /// @param[in] tail_node_data ：获取到该单词时返回的数据
+  /// @param[in] raw_regex_string ：表示单词的正则表达式
+  /// @param[in,out] next_character_index ：指向下一个读取的字符位置的下标的指针
+  /// @return 返回值前半部分为NFA头结点ID，后半部分为其中一个尾节点ID
+  /// @details
+  /// 1.正则先解析为语法树，每个[]、.或单字符为一个位置，每个位置生成一个节点
+  /// 2.NFA头结点直接条件转移到所有可以作为第一个字符的位置，每个位置条件转移
+  /// 到所有可以跟随的位置，所有可以作为最后一个字符的位置均为尾节点
+  /// 3.生成的结构不含无条件转移，不需要MergeOptimization
+  /// @note 正则为空时返回值两部分都为NfaNodeId::InvalidId()
+  /// 正则可以匹配空串时输出错误信息后退出
+  std::pair<NfaNodeId, NfaNodeId> GlushkovConstruct(
+      TailNodeData&& tail_node_data, const std::string& raw_regex_string,
+      size_t* const next_character_index);
 
   /// @brief NFA头结点ID
   NfaNodeId head_node_id_;
-  /// @brief 储存尾节点ID到尾节点数据的映射
-  std::unordered_map<NfaNodeId, TailNodeData> tail_nodes_;
-  /// @brief 储存NFA节点
-  frontend::common::MultimapObjectManager<NfaNode> node_manager_;
+  /// @brief 储存NFA节点，下标为NfaNodeId的值
+  std::vector<NfaNode> nodes_;
+  /// @brief 并查集，存储每个节点合并到的节点的下标，未合并的节点存储自身下标
+  std::vector<uint32_t> merge_parents_;
+  /// @brief 每个节点的尾节点数据在tail_datas_中的下标，非尾节点为kNoTailNodeData
+  /// @note 只有代表节点的下标有效
+  std::vector<uint32_t> tail_data_indexes_;
+  /// @brief 储存尾节点数据
+  std::vector<TailNodeData> tail_datas_;
+  /// @brief 按CSR格式存储的所有转移
+  EdgeArray edge_array_;
+  /// @brief Closure中标记已访问的节点，值等于closure_mark_generation_代表已访问
+  std::vector<uint32_t> closure_marks_;
+  /// @brief 本次调用Closure使用的标记
+  uint32_t closure_mark_generation_ = 0;
 };
 
 }  // namespace frontend::generator::dfa_generator::nfa_generator
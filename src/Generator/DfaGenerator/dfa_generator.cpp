@@ -1,32 +1,67 @@
 ﻿#include "dfa_generator.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/serialization/queue.hpp>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <format>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <span>
 #include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif  // !NOMINMAX
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif  // _WIN32
+
+#define ENABLE_LOG
+#include "Logger/logger.h"
 
 namespace frontend::generator::dfa_generator {
 using frontend::common::kCharNum;
 using frontend::generator::dfa_generator::nfa_generator::NfaGenerator;
 
 void DfaGenerator::DfaInit() {
-  dfa_config_.clear();
+  dfa_config_ = DfaConfig();
+#ifdef USE_LAZY_DFA
+  lazy_dfa_config_ = LazyDfaConfig();
+#endif  // USE_LAZY_DFA
   root_transform_array_id_ = TransformArrayId::InvalidId();
   file_end_saved_data_ = WordAttachedData();
   nfa_generator_.NfaInit();
   root_intermediate_node_id_ = IntermediateNodeId::InvalidId();
   transform_array_size_ = 0;
+  regex_construct_time_ = std::chrono::steady_clock::duration::zero();
+  generation_report_ = GenerationReport();
   intermediate_node_to_final_node_.clear();
   node_manager_intermediate_node_.ObjectManagerInit();
-  node_manager_set_.StructManagerInit();
-  setid_to_intermediate_nodeid_.clear();
 }
 
 bool DfaGenerator::AddWord(const std::string& word,
                            WordAttachedData&& word_attached_data,
                            WordPriority word_priority) {
+  const auto construct_begin = std::chrono::steady_clock::now();
   auto [head_node_id, tail_node_id] = nfa_generator_.WordConstruct(
       word, TailNodeData(std::move(word_attached_data), word_priority));
+  regex_construct_time_ += std::chrono::steady_clock::now() - construct_begin;
   assert(head_node_id.IsValid() && tail_node_id.IsValid());
   return true;
 }
@@ -34,63 +69,629 @@ bool DfaGenerator::AddWord(const std::string& word,
 bool DfaGenerator::AddRegexpression(const std::string& regex_str,
                                     WordAttachedData&& regex_attached_data,
                                     WordPriority regex_priority) {
+  const auto construct_begin = std::chrono::steady_clock::now();
   auto [head_node_id, tail_node_id] = nfa_generator_.RegexConstruct(
       TailNodeData(std::move(regex_attached_data), regex_priority), regex_str);
+  regex_construct_time_ += std::chrono::steady_clock::now() - construct_begin;
   if (!head_node_id.IsValid() || !tail_node_id.IsValid()) [[unlikely]] {
     return false;
   }
   return true;
 }
 
-bool DfaGenerator::DfaConstruct() {
+bool DfaGenerator::DfaConstruct(size_t thread_num) {
+  // 正则构建分散在多次AddWord和AddRegexpression中，记录耗时之和
+  RecordPhase("RegexConstruct", regex_construct_time_);
+  generation_report_.nfa_size_before_merge = nfa_generator_.GetNfaSize();
+  auto phase_begin = std::chrono::steady_clock::now();
   nfa_generator_.MergeOptimization();
-  NfaNodeId nfa_head_handler = nfa_generator_.GetHeadNfaNodeId();
-  auto&& [set_now, tail_data] = nfa_generator_.Closure(nfa_head_handler);
-  assert(tail_data == NfaGenerator::kNotTailNodeTag);
-  auto [root_itermediate_node_id, inserted] = InOrInsert(std::move(set_now));
-  assert(inserted);
-  std::queue<IntermediateNodeId> q;
-  q.push(root_itermediate_node_id);
-  root_intermediate_node_id_ = root_itermediate_node_id;
-  while (!q.empty()) {
-    IntermediateNodeId intermediate_node_handler_now = q.front();
-    q.pop();
-    SetId set_handler_now =
-        GetIntermediateNode(intermediate_node_handler_now).set_handler;
-    for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
-      auto [transformed_intermediate_node_id, inserted] =
-          SetGoto(set_handler_now, static_cast<char>(i));
-      if (!transformed_intermediate_node_id.IsValid()) {
-        // 该字符下不可转移
+  RecordPhase("MergeOptimization",
+              std::chrono::steady_clock::now() - phase_begin);
+  generation_report_.nfa_size_after_merge = nfa_generator_.GetNfaSize();
+#ifdef USE_LAZY_DFA
+  // DFA状态由DfaParser在运行时按需构建
+  phase_begin = std::chrono::steady_clock::now();
+  lazy_dfa_config_ = NfaCompact();
+  RecordPhase("NfaCompact", std::chrono::steady_clock::now() - phase_begin);
+#else
+  phase_begin = std::chrono::steady_clock::now();
+  SubsetConstruct(thread_num);
+  RecordPhase("SubsetConstruct",
+              std::chrono::steady_clock::now() - phase_begin);
+  phase_begin = std::chrono::steady_clock::now();
+  DfaMinimize();
+  RecordPhase("DfaMinimize", std::chrono::steady_clock::now() - phase_begin);
+  generation_report_.dfa_state_num_after_minimize = dfa_config_.GetStateNum();
+#endif  // USE_LAZY_DFA
+  return true;
+}
+
+namespace {
+/// @brief 计算位集合的64位哈希值
+/// @param[in] words ：位集合的首个字
+/// @param[in] word_num ：位集合的字数
+/// @return 返回哈希值
+uint64_t BitsetHash(const uint64_t* words, size_t word_num) {
+  uint64_t hash = 0x9E3779B97F4A7C15ull;
+  for (size_t i = 0; i < word_num; i++) {
+    hash = (hash ^ words[i]) * 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 31;
+  }
+  return hash;
+}
+
+/// @brief 子集构造中表示转移到的集合不代表任何单词的闭包编号
+constexpr size_t kNoWordClosure = std::numeric_limits<size_t>::max();
+/// @brief 生成过程统计报告中记录的最大集合数目
+constexpr size_t kLargestNfaSetRecordNum = 8;
+
+/// @class SetTransfer dfa_generator.cpp
+/// @brief 子集构造得到的集合间转移，移入[begin, end)内的字符后转移到编号为
+/// target的集合
+struct SetTransfer {
+  unsigned begin;
+  unsigned end;
+  size_t target;
+  /// @brief 转移到的集合中代表最高优先级单词的闭包编号
+  /// @note 集合第一次被发现时使用该闭包的单词数据创建中间节点
+  /// 不代表任何单词时为kNoWordClosure
+  size_t word_closure;
+};
+
+/// @class SubsetTransferCalculator dfa_generator.cpp
+/// @brief 计算子集构造中一个集合在每个基本区间下转移到的集合
+/// @details
+/// 集合成员所有条件转移范围的边界将字符划分为基本区间，基本区间内所有字符
+/// 转移到相同的集合，每个基本区间只计算一次
+/// @note 对象内保存计算使用的缓冲区，每个线程使用独立的对象
+class SubsetTransferCalculator {
+ public:
+  /// @class IntervalTransfer dfa_generator.cpp
+  /// @brief 一个基本区间的转移结果
+  struct IntervalTransfer {
+    unsigned begin;
+    unsigned end;
+    /// @brief 转移到的集合的位集合
+    const uint64_t* bits;
+    /// @brief 转移到的集合中代表最高优先级单词的闭包编号
+    /// @note 不代表任何单词时为kNoWordClosure
+    size_t word_closure;
+  };
+
+  /// @param[in] compacted_nfa ：压缩编号后的NFA
+  /// @param[in] closure_bits ：所有闭包的位集合
+  /// @param[in] word_num ：每个位集合的字数
+  /// @note 参数在对象生命周期内必须保持有效且不被修改
+  SubsetTransferCalculator(const LazyDfaConfig& compacted_nfa,
+                           const std::vector<uint64_t>& closure_bits,
+                           size_t word_num)
+      : compacted_nfa_(&compacted_nfa),
+        closure_bits_(&closure_bits),
+        word_num_(word_num) {}
+
+  /// @brief 获取每个位集合的字数
+  size_t GetWordNum() const { return word_num_; }
+  /// @brief 计算集合在所有基本区间下转移到的集合
+  /// @param[in] set_bits ：集合的位集合
+  /// @return 返回所有可以转移的基本区间，按char从小到大排列
+  /// @note 返回值和其中的位集合在下次调用前有效
+  const std::vector<IntervalTransfer>& Calculate(const uint64_t* set_bits);
+  /// @brief 获取上次调用Calculate时集合的成员数
+  size_t GetMemberNum() const { return members_.size(); }
+
+ private:
+  /// @brief 获取压缩编号对应NFA节点的条件转移
+  /// @param[in] node_index ：NFA节点的压缩编号
+  /// @return 返回该节点的所有条件转移
+  std::span<const LazyDfaConfig::RangeTransfer> GetNodeTransfers(
+      size_t node_index) const {
+    return std::span(compacted_nfa_->transfers)
+        .subspan(compacted_nfa_->transfer_offsets[node_index],
+                 compacted_nfa_->transfer_offsets[node_index + 1] -
+                     compacted_nfa_->transfer_offsets[node_index]);
+  }
+
+  const LazyDfaConfig* compacted_nfa_;
+  const std::vector<uint64_t>* closure_bits_;
+  size_t word_num_;
+  /// @brief 集合所有成员的压缩编号
+  std::vector<size_t> members_;
+  /// @brief 基本区间的边界
+  std::vector<unsigned> cuts_;
+  /// @brief 每个基本区间下转移到的集合
+  std::vector<uint64_t> next_set_bits_;
+  /// @brief 每个基本区间下转移到的集合中代表最高优先级单词的闭包编号
+  std::vector<size_t> next_set_word_closure_;
+  /// @brief 每个基本区间下是否可以转移
+  std::vector<bool> transformable_;
+  /// @brief 可以转移的基本区间
+  std::vector<IntervalTransfer> result_;
+};
+
+const std::vector<SubsetTransferCalculator::IntervalTransfer>&
+SubsetTransferCalculator::Calculate(const uint64_t* set_bits) {
+  // 按char从小到大的顺序处理基本区间，与逐字符处理时创建集合的顺序相同
+  constexpr unsigned kFirstByte = static_cast<uint8_t>(CHAR_MIN);
+  members_.clear();
+  for (size_t i = 0; i < word_num_; i++) {
+    uint64_t word = set_bits[i];
+    while (word != 0) {
+      members_.push_back(i * 64 + std::countr_zero(word));
+      word &= word - 1;
+    }
+  }
+  // 划分基本区间
+  cuts_.assign({0, kFirstByte, kCharNum});
+  for (size_t member : members_) {
+    for (const auto& transfer : GetNodeTransfers(member)) {
+      cuts_.push_back(transfer.low);
+      cuts_.push_back(transfer.high + 1u);
+    }
+  }
+  std::sort(cuts_.begin(), cuts_.end());
+  cuts_.erase(std::unique(cuts_.begin(), cuts_.end()), cuts_.end());
+  const size_t interval_num = cuts_.size() - 1;
+  next_set_bits_.assign(interval_num * word_num_, 0);
+  next_set_word_closure_.assign(interval_num, kNoWordClosure);
+  transformable_.assign(interval_num, false);
+  for (size_t member : members_) {
+    for (const auto& [low, high, closure_index] : GetNodeTransfers(member)) {
+      const uint64_t* bits = &(*closure_bits_)[closure_index * word_num_];
+      for (size_t interval = std::lower_bound(cuts_.begin(), cuts_.end(), low) -
+                             cuts_.begin();
+           cuts_[interval] <= high; interval++) {
+        transformable_[interval] = true;
+        uint64_t* next_bits = &next_set_bits_[interval * word_num_];
+        for (size_t i = 0; i < word_num_; i++) {
+          next_bits[i] |= bits[i];
+        }
+        // 不存在尾节点标记或新的标记优先级大于原来的标记则修改
+        size_t& next_word_closure = next_set_word_closure_[interval];
+        if (compacted_nfa_->IsWordClosure(closure_index)) [[unlikely]] {
+          if (next_word_closure == kNoWordClosure ||
+              compacted_nfa_->closure_word_priority[closure_index] >
+                  compacted_nfa_->closure_word_priority[next_word_closure]) {
+            next_word_closure = closure_index;
+          }
+        }
+      }
+    }
+  }
+  result_.clear();
+  const size_t first_interval =
+      std::lower_bound(cuts_.begin(), cuts_.end(), kFirstByte) - cuts_.begin();
+  for (size_t offset = 0; offset < interval_num; offset++) {
+    size_t interval = (first_interval + offset) % interval_num;
+    if (!transformable_[interval]) {
+      // 该区间内的字符下不可转移
+      continue;
+    }
+    result_.push_back(IntervalTransfer{
+        cuts_[interval], cuts_[interval + 1],
+        &next_set_bits_[interval * word_num_],
+        next_set_word_closure_[interval]});
+  }
+  return result_;
+}
+
+/// @class BitsetSetTable dfa_generator.cpp
+/// @brief 存储子集构造中的集合，通过位集合查找集合编号
+/// @details 使用开放寻址哈希表，大小为2的幂，装填因子不超过1/2
+class BitsetSetTable {
+ public:
+  explicit BitsetSetTable(size_t word_num = 0)
+      : word_num_(word_num), slots_(1024, kEmptySlot) {}
+
+  /// @brief 查找位集合对应的集合，不存在则添加
+  /// @param[in] bits ：要查找的位集合
+  /// @param[in] hash ：bits的哈希值（BitsetHash）
+  /// @return 返回集合编号和是否新添加了集合
+  /// @note 集合编号按添加顺序从0开始分配
+  std::pair<size_t, bool> FindOrInsert(const uint64_t* bits, uint64_t hash);
+  /// @brief 获取集合的位集合
+  /// @param[in] set_index ：集合编号
+  /// @return 返回位集合的首个字
+  /// @note 返回值在下次添加集合前有效
+  const uint64_t* GetBits(size_t set_index) const {
+    return &set_bits_[set_index * word_num_];
+  }
+  /// @brief 获取集合数目
+  size_t Size() const { return set_hashes_.size(); }
+
+ private:
+  static constexpr size_t kEmptySlot = std::numeric_limits<size_t>::max();
+
+  size_t FindSlot(uint64_t hash) const {
+    return static_cast<size_t>(hash) & (slots_.size() - 1);
+  }
+
+  size_t word_num_;
+  /// @brief 所有集合的位集合，第i个集合存储在[i*word_num,(i+1)*word_num)
+  std::vector<uint64_t> set_bits_;
+  /// @brief 每个集合的哈希值
+  std::vector<uint64_t> set_hashes_;
+  /// @brief 存储集合编号的哈希表
+  std::vector<size_t> slots_;
+};
+
+std::pair<size_t, bool> BitsetSetTable::FindOrInsert(const uint64_t* bits,
+                                                     uint64_t hash) {
+  size_t slot = FindSlot(hash);
+  while (slots_[slot] != kEmptySlot) {
+    size_t set_index = slots_[slot];
+    if (set_hashes_[set_index] == hash &&
+        std::memcmp(&set_bits_[set_index * word_num_], bits,
+                    word_num_ * sizeof(uint64_t)) == 0) {
+      return std::make_pair(set_index, false);
+    }
+    slot = (slot + 1) & (slots_.size() - 1);
+  }
+  size_t set_index = set_hashes_.size();
+  slots_[slot] = set_index;
+  set_bits_.insert(set_bits_.end(), bits, bits + word_num_);
+  set_hashes_.push_back(hash);
+  if (set_hashes_.size() * 2 > slots_.size()) {
+    // 扩容并重新插入所有集合
+    slots_.assign(slots_.size() * 2, kEmptySlot);
+    for (size_t i = 0; i < set_hashes_.size(); i++) {
+      size_t new_slot = FindSlot(set_hashes_[i]);
+      while (slots_[new_slot] != kEmptySlot) {
+        new_slot = (new_slot + 1) & (slots_.size() - 1);
+      }
+      slots_[new_slot] = i;
+    }
+  }
+  return std::make_pair(set_index, true);
+}
+
+/// @brief 单线程广度优先遍历所有集合
+/// @param[in] root_bits ：初始集合的位集合
+/// @param[in] calculator ：计算集合转移的对象
+/// @param[out] set_sizes ：每个集合的成员数，下标为集合编号
+/// @return 返回每个集合的所有转移，初始集合编号为0
+/// @note 集合按发现顺序编号
+std::vector<std::vector<SetTransfer>> SubsetExplore(
+    const uint64_t* root_bits, SubsetTransferCalculator calculator,
+    std::vector<size_t>& set_sizes) {
+  const size_t word_num = calculator.GetWordNum();
+  BitsetSetTable table(word_num);
+  table.FindOrInsert(root_bits, BitsetHash(root_bits, word_num));
+  std::vector<std::vector<SetTransfer>> set_transfers;
+  // 集合按创建顺序处理，等价于广度优先遍历
+  for (size_t set_index = 0; set_index < table.Size(); set_index++) {
+    std::vector<SetTransfer> transfers;
+    for (const auto& interval : calculator.Calculate(table.GetBits(set_index))) {
+      size_t next_set_index =
+          table.FindOrInsert(interval.bits, BitsetHash(interval.bits, word_num))
+              .first;
+      transfers.push_back(SetTransfer{interval.begin, interval.end,
+                                      next_set_index, interval.word_closure});
+    }
+    set_sizes.push_back(calculator.GetMemberNum());
+    set_transfers.emplace_back(std::move(transfers));
+  }
+  return set_transfers;
+}
+
+/// @brief 多线程遍历所有集合
+/// @param[in] root_bits ：初始集合的位集合
+/// @param[in] calculator ：计算集合转移的对象，每个线程使用一个副本
+/// @param[in] thread_num ：使用的线程数（包括调用线程）
+/// @param[out] set_sizes ：每个集合的成员数，下标为集合编号
+/// @return 返回每个集合的所有转移和初始集合的编号
+/// @details
+/// 1.每个线程有一个待处理集合的双端队列，新发现的集合放入自己的队列尾部，
+/// 优先从自己的队列尾部取出集合，自己的队列为空时从其它线程的队列头部窃取
+/// 2.集合按哈希值高位分散到多个分片中，每个分片使用独立的锁和BitsetSetTable
+/// 3.集合编号与处理顺序有关，调用方应按广度优先顺序重新编号
+std::pair<std::vector<std::vector<SetTransfer>>, size_t> ParallelSubsetExplore(
+    const uint64_t* root_bits, const SubsetTransferCalculator& calculator,
+    size_t thread_num, std::vector<size_t>& set_sizes) {
+  // 分片数目为2^kShardBits，集合句柄的低kShardBits位为分片编号，
+  // 高位为集合在分片中的编号
+  constexpr size_t kShardBits = 6;
+  constexpr size_t kShardNum = size_t(1) << kShardBits;
+  struct Shard {
+    std::mutex mutex;
+    BitsetSetTable table;
+  };
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<size_t> handles;
+  };
+  const size_t word_num = calculator.GetWordNum();
+  std::vector<Shard> shards(kShardNum);
+  for (auto& shard : shards) {
+    shard.table = BitsetSetTable(word_num);
+  }
+  std::vector<WorkQueue> queues(thread_num);
+  // 已发现但尚未处理完成的集合数，为0时所有集合都已处理
+  std::atomic<size_t> pending_set_num = 1;
+  // 查找位集合对应的集合，不存在则添加，返回集合句柄和是否新添加了集合
+  auto find_or_insert = [&shards, word_num](const uint64_t* bits) {
+    uint64_t hash = BitsetHash(bits, word_num);
+    size_t shard_index = static_cast<size_t>(hash >> (64 - kShardBits));
+    Shard& shard = shards[shard_index];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [set_index, inserted] = shard.table.FindOrInsert(bits, hash);
+    return std::make_pair(set_index << kShardBits | shard_index, inserted);
+  };
+  const size_t root_handle = find_or_insert(root_bits).first;
+  queues.front().handles.push_back(root_handle);
+  // 每个线程处理的集合的句柄、成员数和转移，转移到的集合使用句柄表示
+  std::vector<
+      std::vector<std::tuple<size_t, size_t, std::vector<SetTransfer>>>>
+      thread_results(thread_num);
+  auto worker = [&](size_t thread_index) {
+    SubsetTransferCalculator thread_calculator = calculator;
+    WorkQueue& own_queue = queues[thread_index];
+    std::vector<uint64_t> set_bits(word_num);
+    auto& results = thread_results[thread_index];
+    // 获取一个待处理的集合，先从自己的队列尾部获取，再从其它队列头部窃取
+    auto get_work = [&](size_t* handle) {
+      {
+        std::lock_guard<std::mutex> lock(own_queue.mutex);
+        if (!own_queue.handles.empty()) {
+          *handle = own_queue.handles.back();
+          own_queue.handles.pop_back();
+          return true;
+        }
+      }
+      for (size_t i = 1; i < thread_num; i++) {
+        WorkQueue& victim = queues[(thread_index + i) % thread_num];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.handles.empty()) {
+          *handle = victim.handles.front();
+          victim.handles.pop_front();
+          return true;
+        }
+      }
+      return false;
+    };
+    while (true) {
+      size_t handle;
+      if (!get_work(&handle)) {
+        if (pending_set_num.load(std::memory_order_acquire) == 0) {
+          break;
+        }
+        std::this_thread::yield();
         continue;
       }
-      // 设置转移条件
-      GetIntermediateNode(intermediate_node_handler_now)
-          .forward_nodes[static_cast<char>(i)] =
-          transformed_intermediate_node_id;
-      if (inserted) {
-        // 新集合对应的中间节点以前不存在，插入队列等待处理
-        q.push(transformed_intermediate_node_id);
+      {
+        // 分片添加集合时位集合可能移动，复制后再计算
+        Shard& shard = shards[handle & (kShardNum - 1)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const uint64_t* bits = shard.table.GetBits(handle >> kShardBits);
+        std::copy(bits, bits + word_num, set_bits.begin());
+      }
+      std::vector<SetTransfer> transfers;
+      for (const auto& interval : thread_calculator.Calculate(set_bits.data())) {
+        auto [next_handle, inserted] = find_or_insert(interval.bits);
+        if (inserted) {
+          pending_set_num.fetch_add(1, std::memory_order_relaxed);
+          std::lock_guard<std::mutex> lock(own_queue.mutex);
+          own_queue.handles.push_back(next_handle);
+        }
+        transfers.push_back(SetTransfer{interval.begin, interval.end,
+                                        next_handle, interval.word_closure});
       }
+      results.emplace_back(handle, thread_calculator.GetMemberNum(),
+                           std::move(transfers));
+      pending_set_num.fetch_sub(1, std::memory_order_acq_rel);
     }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < thread_num; i++) {
+    workers.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  // 将句柄转换为连续的编号
+  std::array<size_t, kShardNum> shard_offsets;
+  size_t set_num = 0;
+  for (size_t i = 0; i < kShardNum; i++) {
+    shard_offsets[i] = set_num;
+    set_num += shards[i].table.Size();
+  }
+  auto handle_to_index = [&shard_offsets](size_t handle) {
+    return shard_offsets[handle & (kShardNum - 1)] + (handle >> kShardBits);
+  };
+  std::vector<std::vector<SetTransfer>> set_transfers(set_num);
+  set_sizes.assign(set_num, 0);
+  for (auto& results : thread_results) {
+    for (auto& [handle, member_num, transfers] : results) {
+      for (auto& transfer : transfers) {
+        transfer.target = handle_to_index(transfer.target);
+      }
+      set_sizes[handle_to_index(handle)] = member_num;
+      set_transfers[handle_to_index(handle)] = std::move(transfers);
+    }
+  }
+  return std::make_pair(std::move(set_transfers), handle_to_index(root_handle));
+}
+}  // namespace
+
+LazyDfaConfig DfaGenerator::NfaCompact() {
+  LazyDfaConfig compacted_nfa;
+  // NfaNodeId为连续的下标，使用数组存储映射
+  constexpr uint32_t kNotAssigned = std::numeric_limits<uint32_t>::max();
+  // NFA节点ID到压缩编号的映射
+  std::vector<uint32_t> node_to_index(nfa_generator_.GetNodeNum(),
+                                      kNotAssigned);
+  uint32_t node_num = 0;
+  // 闭包起点NFA节点ID到闭包编号的映射
+  std::vector<uint32_t> source_to_closure(nfa_generator_.GetNodeNum(),
+                                          kNotAssigned);
+  // 已分配压缩编号但未处理条件转移的节点
+  std::vector<std::pair<NfaNodeId, uint32_t>> pending_nodes;
+  auto get_closure = [&](NfaNodeId source) {
+    uint32_t& closure_index = source_to_closure[source];
+    if (closure_index == kNotAssigned) {
+      closure_index =
+          static_cast<uint32_t>(compacted_nfa.closure_word_attached_data.size());
+      auto [closure, tail_data] = nfa_generator_.Closure(source);
+      for (NfaNodeId node_id : closure) {
+        uint32_t& node_index = node_to_index[node_id];
+        if (node_index == kNotAssigned) {
+          node_index = node_num++;
+          pending_nodes.emplace_back(node_id, node_index);
+        }
+        compacted_nfa.closure_members.push_back(node_index);
+      }
+      compacted_nfa.closure_member_offsets.push_back(
+          static_cast<uint32_t>(compacted_nfa.closure_members.size()));
+      compacted_nfa.closure_word_attached_data.emplace_back(
+          std::move(tail_data.first));
+      compacted_nfa.closure_word_priority.push_back(tail_data.second);
+    }
+    return closure_index;
+  };
+  compacted_nfa.root_closure = get_closure(nfa_generator_.GetHeadNfaNodeId());
+  assert(!compacted_nfa.IsWordClosure(compacted_nfa.root_closure));
+  // 每个压缩编号对应节点的条件转移
+  std::vector<std::vector<LazyDfaConfig::RangeTransfer>> node_transfers;
+  while (!pending_nodes.empty()) {
+    auto [node_id, node_index] = pending_nodes.back();
+    pending_nodes.pop_back();
+    std::vector<LazyDfaConfig::RangeTransfer> transfers;
+    for (const auto& [low, high, next_node_id] :
+         nfa_generator_.GetConditionalTransfers(node_id)) {
+      transfers.push_back(
+          LazyDfaConfig::RangeTransfer{low, high, get_closure(next_node_id)});
+    }
+    if (node_transfers.size() <= node_index) {
+      node_transfers.resize(node_index + 1);
+    }
+    node_transfers[node_index] = std::move(transfers);
+  }
+  node_transfers.resize(node_num);
+  // 将条件转移连续存储，同时用所有范围的边界划分字节等价类
+  std::array<bool, kCharNum + 1> is_cut = {};
+  is_cut[0] = true;
+  for (const auto& transfers : node_transfers) {
+    for (const auto& transfer : transfers) {
+      is_cut[transfer.low] = true;
+      is_cut[transfer.high + 1u] = true;
+    }
+    compacted_nfa.transfers.insert(compacted_nfa.transfers.end(),
+                                   transfers.begin(), transfers.end());
+    compacted_nfa.transfer_offsets.push_back(
+        static_cast<uint32_t>(compacted_nfa.transfers.size()));
+  }
+  compacted_nfa.class_num = 0;
+  for (size_t c = 0; c < kCharNum; c++) {
+    if (is_cut[c]) {
+      ++compacted_nfa.class_num;
+    }
+    compacted_nfa.char_to_class[c] =
+        static_cast<uint8_t>(compacted_nfa.class_num - 1);
+  }
+  return compacted_nfa;
+}
+
+void DfaGenerator::SubsetConstruct(size_t thread_num) {
+  // 1.给可达的NFA节点分配压缩编号，每个闭包只计算一次
+  const LazyDfaConfig compacted_nfa = NfaCompact();
+  // 将闭包转换为位集合
+  const size_t word_num = (compacted_nfa.GetNodeNum() + 63) / 64;
+  std::vector<uint64_t> closure_bits(
+      compacted_nfa.GetClosureNum() * word_num, 0);
+  for (size_t i = 0; i < compacted_nfa.GetClosureNum(); i++) {
+    for (size_t j = compacted_nfa.closure_member_offsets[i];
+         j < compacted_nfa.closure_member_offsets[i + 1]; j++) {
+      const size_t member = compacted_nfa.closure_members[j];
+      closure_bits[i * word_num + member / 64] |= uint64_t(1) << (member % 64);
+    }
+  }
+
+  // 2.子集构造
+  SubsetTransferCalculator calculator(compacted_nfa, closure_bits, word_num);
+  const uint64_t* root_bits =
+      &closure_bits[compacted_nfa.root_closure * word_num];
+  std::vector<std::vector<SetTransfer>> set_transfers;
+  std::vector<size_t> set_sizes;
+  size_t root_set_index = 0;
+  if (thread_num > 1) {
+    std::tie(set_transfers, root_set_index) =
+        ParallelSubsetExplore(root_bits, calculator, thread_num, set_sizes);
+  } else {
+    set_transfers = SubsetExplore(root_bits, calculator, set_sizes);
+  }
+  generation_report_.dfa_state_num_before_minimize = set_transfers.size();
+  // 记录成员最多的若干个集合的成员数
+  const size_t recorded_set_num =
+      std::min(set_sizes.size(), kLargestNfaSetRecordNum);
+  std::partial_sort(set_sizes.begin(), set_sizes.begin() + recorded_set_num,
+                    set_sizes.end(), std::greater<size_t>());
+  generation_report_.largest_nfa_set_sizes.assign(
+      set_sizes.begin(), set_sizes.begin() + recorded_set_num);
+
+  // 3.按广度优先顺序创建中间节点，中间节点ID与线程数无关
+  std::vector<IntermediateNodeId> set_to_intermediate_node(
+      set_transfers.size(), IntermediateNodeId::InvalidId());
+  // 按中间节点创建顺序排列的集合编号
+  std::vector<size_t> set_order;
+  set_order.reserve(set_transfers.size());
+  set_to_intermediate_node[root_set_index] =
+      node_manager_intermediate_node_.EmplaceObject(WordAttachedData());
+  set_order.push_back(root_set_index);
+  root_intermediate_node_id_ = set_to_intermediate_node[root_set_index];
+  for (size_t i = 0; i < set_order.size(); i++) {
+    size_t set_index = set_order[i];
+    for (const auto& [begin, end, next_set_index, word_closure] :
+         set_transfers[set_index]) {
+      if (!set_to_intermediate_node[next_set_index].IsValid()) {
+        // 第一次发现该集合，使用发现时的尾节点数据创建中间节点
+        set_to_intermediate_node[next_set_index] =
+            node_manager_intermediate_node_.EmplaceObject(
+                word_closure == kNoWordClosure
+                    ? WordAttachedData()
+                    : compacted_nfa.closure_word_attached_data[word_closure]);
+        set_order.push_back(next_set_index);
+      }
+      // 设置区间内所有字符的转移条件
+      auto& forward_nodes =
+          GetIntermediateNode(set_to_intermediate_node[set_index])
+              .forward_nodes;
+      for (unsigned c = begin; c < end; c++) {
+        forward_nodes[static_cast<char>(c)] =
+            set_to_intermediate_node[next_set_index];
+      }
+    }
+    // 释放已处理集合的转移
+    set_transfers[set_index] = std::vector<SetTransfer>();
   }
-  DfaMinimize();
-  return true;
 }
 
 bool DfaGenerator::DfaMinimize() {
   transform_array_size_ = 0;  // 清零最终有效节点数
+#ifdef USE_HOPCROFT_DFA_MINIMIZE
+  HopcroftClassify();
+#ifdef _DEBUG
+  CheckHopcroftClassify();
+#endif  // _DEBUG
+#else
   std::list<IntermediateNodeId> nodes;
   for (auto iter = node_manager_intermediate_node_.Begin();
        iter != node_manager_intermediate_node_.End(); ++iter) {
     nodes.push_back(iter.GetId());
   }
   IntermediateNodeClassify(std::move(nodes));
-  dfa_config_.resize(transform_array_size_);
-  for (auto& p : dfa_config_) {
-    // 填充整个转移表为无法转移状态
-    p.first.fill(TransformArrayId::InvalidId());
+#endif  // USE_HOPCROFT_DFA_MINIMIZE
+  if (transform_array_size_ > DfaConfig::kMaxStateNum) [[unlikely]] {
+    LOG_ERROR("DfaGenerator",
+              std::format("DFA状态数{:}超过转移表可表示的最大状态数{:}",
+                          transform_array_size_, DfaConfig::kMaxStateNum))
+    exit(-1);
   }
+  // 未压缩的转移表，下标为字符*状态数+状态编号
+  // 按列存储以便下面比较每个字符在所有状态下的转移结果
+  std::vector<DfaConfig::StateIndex> transform_columns(
+      kCharNum * transform_array_size_, DfaConfig::kInvalidStateIndex);
+  dfa_config_.word_attached_data.clear();
+  dfa_config_.word_attached_data.resize(transform_array_size_);
   // 标记转移表条目是否完成构建
   std::vector<bool> logged_index(transform_array_size_, false);
   for (auto& p : intermediate_node_to_final_node_) {
@@ -98,17 +699,22 @@ bool DfaGenerator::DfaMinimize() {
     IntermediateDfaNode& intermediate_node = GetIntermediateNode(p.first);
     if (logged_index[index] == false) {
       // 该状态转移表条目未配置
-      dfa_config_[index].second = intermediate_node.word_attached_data;
-      for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
+      dfa_config_.word_attached_data[index] =
+          intermediate_node.word_attached_data;
+      for (size_t i = 0; i < kCharNum; i++) {
         // 寻找有效节点并设置语法分析表中对应项
-        // 从最小的char开始
         IntermediateNodeId next_node_id =
             intermediate_node.forward_nodes[static_cast<char>(i)];
         if (next_node_id.IsValid()) [[unlikely]] {
           // 该条件下可以转移，查询转移到的中间节点对应转移表条目ID
+          // Hopcroft算法删除了无法到达接受状态的节点，转移到这些节点视为
+          // 无法转移
           auto iter = intermediate_node_to_final_node_.find(next_node_id);
-          assert(iter != intermediate_node_to_final_node_.end());
-          dfa_config_[index].first[static_cast<char>(i)] = iter->second;
+          if (iter != intermediate_node_to_final_node_.end()) [[likely]] {
+            transform_columns[i * transform_array_size_ + index] =
+                static_cast<DfaConfig::StateIndex>(
+                    iter->second.GetRawValue());
+          }
         }
       }
       logged_index[index] = true;
@@ -120,6 +726,8 @@ bool DfaGenerator::DfaMinimize() {
     assert(logged);
   }
 #endif  // _DEBUG
+  ByteEquivalenceClassify(transform_columns);
+  SelfLoopByteRangesConstruct();
   root_transform_array_id_ =
       intermediate_node_to_final_node_.find(root_intermediate_node_id_)->second;
   assert(root_transform_array_id_.IsValid());
@@ -130,29 +738,196 @@ bool DfaGenerator::DfaMinimize() {
   return true;
 }
 
-std::pair<DfaGenerator::IntermediateNodeId, bool> DfaGenerator::SetGoto(
-    SetId set_src, char c_transform) {
-  SetType set;
-  TailNodeData tail_data(NfaGenerator::kNotTailNodeTag);
-  for (auto x : GetSetObject(set_src)) {
-    auto [set_temp, tail_data_temp] = nfa_generator_.Goto(x, c_transform);
-    if (set_temp.empty()) [[likely]] {
-      continue;
+void DfaGenerator::ByteEquivalenceClassify(
+    const std::vector<DfaConfig::StateIndex>& transform_columns) {
+  const size_t state_num = transform_array_size_;
+  // 键为字符在所有状态下的转移结果（转移表的一列），值为等价类编号
+  std::map<std::vector<DfaConfig::StateIndex>, uint8_t> column_to_class;
+  for (size_t i = 0; i < kCharNum; i++) {
+    auto column_begin = transform_columns.begin() + i * state_num;
+    auto [iter, inserted] = column_to_class.emplace(
+        std::vector<DfaConfig::StateIndex>(column_begin,
+                                           column_begin + state_num),
+        static_cast<uint8_t>(column_to_class.size()));
+    dfa_config_.char_to_class[i] = iter->second;
+  }
+  dfa_config_.class_num = column_to_class.size();
+  // 每个等价类只保存一列，转移表按状态行优先存储
+  dfa_config_.transform_table.assign(state_num * dfa_config_.class_num,
+                                     DfaConfig::kInvalidStateIndex);
+  for (const auto& [column, class_index] : column_to_class) {
+    for (size_t state = 0; state < state_num; state++) {
+      dfa_config_.transform_table[state * dfa_config_.class_num +
+                                  class_index] = column[state];
+    }
+  }
+#ifdef _DEBUG
+  // 检查压缩后的转移表与压缩前完全相同
+  for (size_t state = 0; state < state_num; state++) {
+    for (size_t i = 0; i < kCharNum; i++) {
+      assert(dfa_config_.Transform(static_cast<DfaConfig::StateIndex>(state),
+                                   static_cast<char>(i)) ==
+             transform_columns[i * state_num + state]);
     }
-    set.merge(std::move(set_temp));
-    // 不存在尾节点标记或新的标记优先级大于原来的标记则修改
-    if (tail_data_temp != NfaGenerator::kNotTailNodeTag) [[unlikely]] {
-      if (tail_data == NfaGenerator::kNotTailNodeTag ||
-          tail_data_temp.second > tail_data.second) {
-        tail_data = tail_data_temp;
+  }
+#endif  // _DEBUG
+}
+
+void DfaGenerator::SelfLoopByteRangesConstruct() {
+  dfa_config_.self_loop_ranges.assign(dfa_config_.GetStateNum(), ByteRanges());
+  for (size_t state = 0; state < dfa_config_.GetStateNum(); state++) {
+    ByteRanges& ranges = dfa_config_.self_loop_ranges[state];
+    // 当前区间的起始字节，kCharNum表示不在区间中
+    size_t range_begin = kCharNum;
+    bool representable = true;
+    // 多遍历一次i==kCharNum以结束最后一个区间
+    for (size_t i = 0; i <= kCharNum; i++) {
+      bool self_loop =
+          i < kCharNum &&
+          dfa_config_.Transform(static_cast<DfaConfig::StateIndex>(state),
+                                static_cast<char>(i)) == state;
+      if (self_loop && range_begin == kCharNum) {
+        range_begin = i;
+      } else if (!self_loop && range_begin != kCharNum) {
+        if (ranges.range_num == ByteRanges::kMaxRangeNum) {
+          // 区间过多，无法使用SIMD加速，退化为逐字节转移
+          representable = false;
+          break;
+        }
+        ranges.range_begin[ranges.range_num] =
+            static_cast<uint8_t>(range_begin);
+        ranges.range_end[ranges.range_num] = static_cast<uint8_t>(i - 1);
+        ++ranges.range_num;
+        range_begin = kCharNum;
       }
     }
+    if (!representable) {
+      ranges = ByteRanges();
+    }
   }
-  if (set.empty()) {
-    return std::make_pair(IntermediateNodeId::InvalidId(), false);
-  } else {
-    return InOrInsert(std::move(set), std::move(tail_data.first));
+}
+
+namespace {
+/// @brief 行位移压缩时默认状态链的最大长度
+/// @note 查询转移时每经过一个默认状态需要多访问一次base/check
+constexpr size_t kMaxDefaultStateChainLength = 3;
+/// @brief 行位移压缩时为每个状态选择默认状态考察的之前的状态数
+/// @note 限制选择默认状态的时间复杂度为O(状态数*该值*等价类数)
+constexpr size_t kDefaultStateCandidateNum = 512;
+}  // namespace
+
+CombDfaConfig DfaGenerator::CombDfaConfigConstruct() const {
+  using StateIndex = DfaConfig::StateIndex;
+  constexpr StateIndex kInvalidStateIndex = DfaConfig::kInvalidStateIndex;
+  const size_t state_num = dfa_config_.GetStateNum();
+  const size_t class_num = dfa_config_.class_num;
+  auto get_row = [this, class_num](size_t state) {
+    return std::span(dfa_config_.transform_table)
+        .subspan(state * class_num, class_num);
+  };
+  CombDfaConfig comb_dfa_config;
+  comb_dfa_config.char_to_class = dfa_config_.char_to_class;
+  comb_dfa_config.class_num = class_num;
+  comb_dfa_config.word_attached_data = dfa_config_.word_attached_data;
+  comb_dfa_config.self_loop_ranges = dfa_config_.self_loop_ranges;
+  comb_dfa_config.default_state.assign(state_num, kInvalidStateIndex);
+  // 每个状态需要存储的条目的等价类编号
+  std::vector<std::vector<uint8_t>> state_entries(state_num);
+  // 每个状态所在默认状态链的长度（不含自身）
+  std::vector<size_t> chain_length(state_num, 0);
+  for (size_t state = 0; state < state_num; state++) {
+    const auto row = get_row(state);
+    size_t best_entry_num = std::count_if(
+        row.begin(), row.end(),
+        [](StateIndex target) { return target != kInvalidStateIndex; });
+    StateIndex best_default_state = kInvalidStateIndex;
+    // 只选择编号更小的状态作为默认状态，保证默认状态链无环
+    for (size_t candidate =
+             state > kDefaultStateCandidateNum ? state - kDefaultStateCandidateNum
+                                               : 0;
+         candidate < state; candidate++) {
+      if (chain_length[candidate] + 1 > kMaxDefaultStateChainLength) {
+        continue;
+      }
+      const auto candidate_row = get_row(candidate);
+      size_t different_entry_num = 0;
+      for (size_t class_id = 0;
+           class_id < class_num && different_entry_num < best_entry_num;
+           class_id++) {
+        different_entry_num += row[class_id] != candidate_row[class_id];
+      }
+      if (different_entry_num < best_entry_num) {
+        best_entry_num = different_entry_num;
+        best_default_state = static_cast<StateIndex>(candidate);
+      }
+    }
+    std::vector<uint8_t>& entries = state_entries[state];
+    entries.reserve(best_entry_num);
+    for (size_t class_id = 0; class_id < class_num; class_id++) {
+      if (best_default_state == kInvalidStateIndex
+              ? row[class_id] != kInvalidStateIndex
+              : row[class_id] != get_row(best_default_state)[class_id]) {
+        entries.push_back(static_cast<uint8_t>(class_id));
+      }
+    }
+    if (best_default_state != kInvalidStateIndex) {
+      comb_dfa_config.default_state[state] = best_default_state;
+      chain_length[state] = chain_length[best_default_state] + 1;
+    }
+  }
+  // 按需要存储的条目数从多到少的顺序放置各状态的行
+  std::vector<size_t> place_order(state_num);
+  for (size_t state = 0; state < state_num; state++) {
+    place_order[state] = state;
   }
+  std::stable_sort(place_order.begin(), place_order.end(),
+                   [&state_entries](size_t lhs, size_t rhs) {
+                     return state_entries[lhs].size() >
+                            state_entries[rhs].size();
+                   });
+  std::vector<StateIndex>& next = comb_dfa_config.next;
+  std::vector<StateIndex>& check = comb_dfa_config.check;
+  comb_dfa_config.base.assign(state_num, 0);
+  // 第一个空位，之前的位置都已被占用
+  size_t first_free_index = 0;
+  for (size_t state : place_order) {
+    const std::vector<uint8_t>& entries = state_entries[state];
+    if (entries.empty()) {
+      // 所有转移都查询默认状态，base取任意值都不会匹配check
+      continue;
+    }
+    // 第一个条目放在第一个空位时的base，更小的base会与已有条目冲突
+    size_t base = first_free_index > entries.front()
+                      ? first_free_index - entries.front()
+                      : 0;
+    while (true) {
+      if (check.size() < base + class_num) {
+        check.resize(base + class_num, kInvalidStateIndex);
+      }
+      if (std::all_of(entries.begin(), entries.end(),
+                      [&check, base](uint8_t class_id) {
+                        return check[base + class_id] == kInvalidStateIndex;
+                      })) {
+        break;
+      }
+      ++base;
+    }
+    comb_dfa_config.base[state] = static_cast<uint32_t>(base);
+    const auto row = get_row(state);
+    next.resize(check.size(), kInvalidStateIndex);
+    for (uint8_t class_id : entries) {
+      check[base + class_id] = static_cast<StateIndex>(state);
+      next[base + class_id] = row[class_id];
+    }
+    while (first_free_index < check.size() &&
+           check[first_free_index] != kInvalidStateIndex) {
+      ++first_free_index;
+    }
+  }
+  // 保证没有条目的状态查询时也不越界
+  check.resize(std::max(check.size(), class_num), kInvalidStateIndex);
+  next.resize(check.size(), kInvalidStateIndex);
+  return comb_dfa_config;
 }
 
 inline DfaGenerator::IntermediateNodeId DfaGenerator::IntermediateGoto(
@@ -210,6 +985,453 @@ void DfaGenerator::IntermediateNodeClassify(
   }
 }
 
+void DfaGenerator::HopcroftClassify() {
+  // 为中间节点分配连续的下标，最后一个下标为补全DFA用的死状态
+  std::vector<IntermediateNodeId> node_ids;
+  std::unordered_map<IntermediateNodeId, uint32_t> node_id_to_index;
+  for (auto iter = node_manager_intermediate_node_.Begin();
+       iter != node_manager_intermediate_node_.End(); ++iter) {
+    node_id_to_index.emplace(iter.GetId(),
+                             static_cast<uint32_t>(node_ids.size()));
+    node_ids.push_back(iter.GetId());
+  }
+  const uint32_t node_num = static_cast<uint32_t>(node_ids.size());
+  const uint32_t dead_state = node_num;
+  const uint32_t state_num = node_num + 1;
+  // 在所有状态下转移结果都相同的字符对划分的作用相同，只需处理一次
+  // 键为字符在所有节点下转移到的下标，值为字节等价类编号
+  std::map<std::vector<uint32_t>, uint32_t> column_to_class;
+  for (size_t i = 0; i < kCharNum; i++) {
+    std::vector<uint32_t> column(node_num, dead_state);
+    for (uint32_t state = 0; state < node_num; state++) {
+      IntermediateNodeId next_node_id =
+          IntermediateGoto(node_ids[state], static_cast<char>(i));
+      if (next_node_id.IsValid()) {
+        column[state] = node_id_to_index.find(next_node_id)->second;
+      }
+    }
+    column_to_class.emplace(std::move(column),
+                            static_cast<uint32_t>(column_to_class.size()));
+  }
+  const size_t class_num = column_to_class.size();
+  // 逆向转移表：predecessors[predecessor_offsets[k*(state_num+1)+t]...
+  // predecessor_offsets[k*(state_num+1)+t+1]]为在第k类字符下转移到t的状态
+  // 死状态在任何字符下都转移到自身
+  std::vector<uint32_t> predecessor_offsets(class_num * (state_num + 1), 0);
+  std::vector<uint32_t> predecessors(class_num * state_num);
+  for (const auto& [column, class_index] : column_to_class) {
+    uint32_t* offsets = &predecessor_offsets[class_index * (state_num + 1)];
+    for (uint32_t target : column) {
+      ++offsets[target + 1];
+    }
+    ++offsets[dead_state + 1];
+    for (uint32_t state = 0; state < state_num; state++) {
+      offsets[state + 1] += offsets[state];
+    }
+    // 逐个填写时使用的下一个空位
+    std::vector<uint32_t> fill_position(offsets, offsets + state_num);
+    for (uint32_t state = 0; state < node_num; state++) {
+      predecessors[class_index * state_num + fill_position[column[state]]++] =
+          state;
+    }
+    predecessors[class_index * state_num + fill_position[dead_state]++] =
+        dead_state;
+  }
+
+  // 划分：elements中每个块占据连续区间[block_begin,block_end)，
+  // 其中[block_begin,block_marked_end)为本轮被标记的状态
+  std::vector<uint32_t> elements;
+  std::vector<uint32_t> location(state_num);
+  std::vector<uint32_t> block_of(state_num);
+  std::vector<uint32_t> block_begin, block_end, block_marked_end;
+  // 初始划分：单词数据相同的状态在同一块中，产生式节点ID唯一决定单词数据
+  std::map<size_t, std::vector<uint32_t>> initial_blocks;
+  for (uint32_t state = 0; state < node_num; state++) {
+    initial_blocks[GetIntermediateNode(node_ids[state])
+                       .word_attached_data.production_node_id.GetRawValue()]
+        .push_back(state);
+  }
+  initial_blocks[WordAttachedData().production_node_id.GetRawValue()]
+      .push_back(dead_state);
+  for (const auto& [production_node_id, states] : initial_blocks) {
+    const uint32_t block = static_cast<uint32_t>(block_begin.size());
+    block_begin.push_back(static_cast<uint32_t>(elements.size()));
+    block_marked_end.push_back(block_begin.back());
+    for (uint32_t state : states) {
+      location[state] = static_cast<uint32_t>(elements.size());
+      block_of[state] = block;
+      elements.push_back(state);
+    }
+    block_end.push_back(static_cast<uint32_t>(elements.size()));
+  }
+  // 待作为划分依据的块
+  std::vector<uint32_t> worklist(block_begin.size());
+  std::vector<bool> in_worklist(block_begin.size(), true);
+  for (uint32_t block = 0; block < worklist.size(); block++) {
+    worklist[block] = block;
+  }
+  // 本轮有状态被标记的块
+  std::vector<uint32_t> touched_blocks;
+  // 作为划分依据的块的状态，划分过程中块可能改变所以需要复制
+  std::vector<uint32_t> splitter_states;
+  while (!worklist.empty()) {
+    const uint32_t splitter = worklist.back();
+    worklist.pop_back();
+    in_worklist[splitter] = false;
+    splitter_states.assign(elements.begin() + block_begin[splitter],
+                           elements.begin() + block_end[splitter]);
+    for (size_t class_index = 0; class_index < class_num; class_index++) {
+      const uint32_t* offsets =
+          &predecessor_offsets[class_index * (state_num + 1)];
+      const uint32_t* class_predecessors =
+          &predecessors[class_index * state_num];
+      // 标记在该类字符下转移到划分依据中的状态
+      for (uint32_t target : splitter_states) {
+        for (uint32_t i = offsets[target]; i < offsets[target + 1]; i++) {
+          const uint32_t state = class_predecessors[i];
+          const uint32_t block = block_of[state];
+          const uint32_t marked_end = block_marked_end[block];
+          if (location[state] < marked_end) {
+            // 已经标记过
+            continue;
+          }
+          if (marked_end == block_begin[block]) {
+            touched_blocks.push_back(block);
+          }
+          // 与第一个未标记的状态交换位置
+          const uint32_t swapped_state = elements[marked_end];
+          elements[location[state]] = swapped_state;
+          location[swapped_state] = location[state];
+          elements[marked_end] = state;
+          location[state] = marked_end;
+          ++block_marked_end[block];
+        }
+      }
+      // 将被标记的部分分裂为新块
+      for (uint32_t block : touched_blocks) {
+        const uint32_t marked_end = block_marked_end[block];
+        block_marked_end[block] = block_begin[block];
+        if (marked_end == block_end[block]) {
+          // 整块都被标记，不需要分裂
+          continue;
+        }
+        const uint32_t new_block = static_cast<uint32_t>(block_begin.size());
+        block_begin.push_back(block_begin[block]);
+        block_end.push_back(marked_end);
+        block_marked_end.push_back(block_begin[block]);
+        block_begin[block] = marked_end;
+        block_marked_end[block] = marked_end;
+        for (uint32_t i = block_begin[new_block]; i < marked_end; i++) {
+          block_of[elements[i]] = new_block;
+        }
+        // 原块已在工作表中则两部分都需要处理，否则只需处理较小的部分
+        const bool new_block_smaller =
+            block_end[new_block] - block_begin[new_block] <
+            block_end[block] - block_begin[block];
+        if (in_worklist[block] || new_block_smaller) {
+          worklist.push_back(new_block);
+          in_worklist.push_back(true);
+        } else {
+          worklist.push_back(block);
+          in_worklist[block] = true;
+          in_worklist.push_back(false);
+        }
+      }
+      touched_blocks.clear();
+    }
+  }
+
+  // 每块映射为一条DFA转移表条目
+  // 与死状态等价的节点无法到达接受状态，直接删除，转移到这些节点视为无法转移
+  // 起始节点与死状态等价时（没有任何单词）保留该块
+  const uint32_t dead_block = block_of[dead_state];
+  const uint32_t root_block =
+      block_of[node_id_to_index.find(root_intermediate_node_id_)->second];
+  for (uint32_t block = 0; block < block_begin.size(); block++) {
+    if (block == dead_block && block != root_block) {
+      continue;
+    }
+    for (uint32_t i = block_begin[block]; i < block_end[block]; i++) {
+      if (elements[i] != dead_state) {
+        intermediate_node_to_final_node_.emplace(node_ids[elements[i]],
+                                                 transform_array_size_);
+      }
+    }
+    ++transform_array_size_;
+  }
+}
+
+#ifdef _DEBUG
+void DfaGenerator::CheckHopcroftClassify() {
+  auto hopcroft_result = std::move(intermediate_node_to_final_node_);
+  const size_t hopcroft_state_num = transform_array_size_;
+  // 获取中间节点在Hopcroft算法结果中的条目，被删除的节点返回无效值
+  auto get_hopcroft_index = [&hopcroft_result](IntermediateNodeId node_id) {
+    if (!node_id.IsValid()) {
+      return TransformArrayId::InvalidId();
+    }
+    auto iter = hopcroft_result.find(node_id);
+    return iter == hopcroft_result.end() ? TransformArrayId::InvalidId()
+                                         : iter->second;
+  };
+  // 1.划分是同余关系：同一块中的节点单词数据相同，在任何字符下都转移到同一块
+  // 因此合并后的DFA与合并前接受相同的单词
+  std::unordered_map<TransformArrayId, IntermediateNodeId> representatives;
+  for (const auto& [node_id, index] : hopcroft_result) {
+    auto [iter, inserted] = representatives.emplace(index, node_id);
+    const IntermediateDfaNode& node = GetIntermediateNode(node_id);
+    const IntermediateDfaNode& representative =
+        GetIntermediateNode(iter->second);
+    assert(node.word_attached_data == representative.word_attached_data);
+    for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
+      assert(get_hopcroft_index(node.forward_nodes[static_cast<char>(c)]) ==
+             get_hopcroft_index(
+                 representative.forward_nodes[static_cast<char>(c)]));
+    }
+  }
+  // 2.用原分类方法重新分类，两者的结果必须同构：
+  // 状态数相同，原分类的条目到Hopcroft算法结果的条目的映射是双射，
+  // 且对应条目的单词数据相同、在任何字符下都转移到对应的条目
+  // 子集构造得到的节点都可以到达接受状态，不存在与死状态等价而被删除的节点
+  std::list<IntermediateNodeId> nodes;
+  for (auto iter = node_manager_intermediate_node_.Begin();
+       iter != node_manager_intermediate_node_.End(); ++iter) {
+    nodes.push_back(iter.GetId());
+  }
+  transform_array_size_ = 0;
+  IntermediateNodeClassify(std::move(nodes));
+  assert(hopcroft_state_num == transform_array_size_);
+  // 原分类的条目到Hopcroft算法结果的条目的映射
+  std::unordered_map<TransformArrayId, TransformArrayId> classify_to_hopcroft;
+  // 原分类的每个条目的代表节点
+  std::unordered_map<TransformArrayId, IntermediateNodeId>
+      classify_representatives;
+  for (const auto& [node_id, index] : intermediate_node_to_final_node_) {
+    const TransformArrayId hopcroft_index = get_hopcroft_index(node_id);
+    assert(hopcroft_index.IsValid());
+    auto [iter, inserted] =
+        classify_to_hopcroft.emplace(index, hopcroft_index);
+    assert(iter->second == hopcroft_index);
+    classify_representatives.emplace(index, node_id);
+  }
+  assert(classify_to_hopcroft.size() == transform_array_size_);
+  // 映射是单射，条目数相同所以是双射
+  std::unordered_set<TransformArrayId> hopcroft_indexes_mapped;
+  for (const auto& [classify_index, hopcroft_index] : classify_to_hopcroft) {
+    [[maybe_unused]] bool inserted =
+        hopcroft_indexes_mapped.insert(hopcroft_index).second;
+    assert(inserted);
+  }
+  // 获取中间节点在原分类结果中的条目，无法转移时返回无效值
+  auto get_classify_index = [this](IntermediateNodeId node_id) {
+    if (!node_id.IsValid()) {
+      return TransformArrayId::InvalidId();
+    }
+    return intermediate_node_to_final_node_.find(node_id)->second;
+  };
+  // 对应的条目单词数据相同，转移也对应
+  for (const auto& [classify_index, node_id] : classify_representatives) {
+    const TransformArrayId hopcroft_index =
+        classify_to_hopcroft.find(classify_index)->second;
+    const IntermediateDfaNode& node = GetIntermediateNode(node_id);
+    const IntermediateDfaNode& hopcroft_representative =
+        GetIntermediateNode(representatives.find(hopcroft_index)->second);
+    assert(node.word_attached_data ==
+           hopcroft_representative.word_attached_data);
+    for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
+      const TransformArrayId classify_next_index =
+          get_classify_index(node.forward_nodes[static_cast<char>(c)]);
+      const TransformArrayId hopcroft_next_index = get_hopcroft_index(
+          hopcroft_representative.forward_nodes[static_cast<char>(c)]);
+      if (classify_next_index.IsValid()) {
+        assert(classify_to_hopcroft.find(classify_next_index)->second ==
+               hopcroft_next_index);
+      } else {
+        assert(!hopcroft_next_index.IsValid());
+      }
+    }
+  }
+  intermediate_node_to_final_node_ = std::move(hopcroft_result);
+  transform_array_size_ = hopcroft_state_num;
+}
+#endif  // _DEBUG
+
+bool DfaGenerator::ProfileGuidedStateRenumber(
+    const std::string& corpus_file_path) {
+#ifdef USE_LAZY_DFA
+  LOG_WARNING("DfaGenerator",
+              "Lazy DFA doesn't construct DFA states, renumbering skipped")
+  return false;
+#else
+  const auto renumber_begin = std::chrono::steady_clock::now();
+  std::ifstream corpus_file(corpus_file_path,
+                            std::ios_base::binary | std::ios_base::in);
+  if (!corpus_file.is_open()) [[unlikely]] {
+    LOG_ERROR("DfaGenerator",
+              std::format("无法打开语料文件{:}", corpus_file_path))
+    return false;
+  }
+  const std::string corpus{std::istreambuf_iterator<char>(corpus_file),
+                           std::istreambuf_iterator<char>()};
+  const size_t state_num = dfa_config_.GetStateNum();
+  const auto root_state =
+      static_cast<DfaConfig::StateIndex>(root_transform_array_id_.GetRawValue());
+  // 模拟DfaParser的最长匹配，统计每个状态被到达的次数
+  std::vector<size_t> visit_counts(state_num, 0);
+  const char* character_now = corpus.data();
+  const char* const corpus_end = corpus.data() + corpus.size();
+  while (true) {
+    while (character_now != corpus_end &&
+           std::isspace(static_cast<unsigned char>(*character_now))) {
+      ++character_now;
+    }
+    if (character_now == corpus_end) {
+      break;
+    }
+    DfaConfig::StateIndex state_now = root_state;
+    ++visit_counts[state_now];
+    const char* word_end = character_now;
+    const char* last_accepted_end = nullptr;
+    while (word_end != corpus_end) {
+      DfaConfig::StateIndex next_state =
+          dfa_config_.Transform(state_now, *word_end);
+      if (next_state == DfaConfig::kInvalidStateIndex) {
+        break;
+      }
+      ++word_end;
+      state_now = next_state;
+      ++visit_counts[state_now];
+      if (dfa_config_.word_attached_data[state_now]
+              .production_node_id.IsValid()) {
+        last_accepted_end = word_end;
+      }
+    }
+    // 无法识别的字符跳过一个字节后继续统计
+    character_now =
+        last_accepted_end == nullptr ? character_now + 1 : last_accepted_end;
+  }
+  // 按访问次数从大到小排列原状态编号，new_to_old[新编号] = 原编号
+  std::vector<DfaConfig::StateIndex> new_to_old(state_num);
+  for (size_t state = 0; state < state_num; state++) {
+    new_to_old[state] = static_cast<DfaConfig::StateIndex>(state);
+  }
+  std::stable_sort(new_to_old.begin(), new_to_old.end(),
+                   [&visit_counts](DfaConfig::StateIndex lhs,
+                                   DfaConfig::StateIndex rhs) {
+                     return visit_counts[lhs] > visit_counts[rhs];
+                   });
+  std::vector<DfaConfig::StateIndex> old_to_new(state_num);
+  for (size_t state = 0; state < state_num; state++) {
+    old_to_new[new_to_old[state]] = static_cast<DfaConfig::StateIndex>(state);
+  }
+  // 按新编号重新排列各状态的行并替换转移目标
+  const size_t class_num = dfa_config_.class_num;
+  std::vector<DfaConfig::StateIndex> transform_table(
+      dfa_config_.transform_table.size());
+  std::vector<WordAttachedData> word_attached_data(state_num);
+  std::vector<ByteRanges> self_loop_ranges(state_num);
+  for (size_t new_state = 0; new_state < state_num; new_state++) {
+    const size_t old_state = new_to_old[new_state];
+    for (size_t class_id = 0; class_id < class_num; class_id++) {
+      DfaConfig::StateIndex target =
+          dfa_config_.transform_table[old_state * class_num + class_id];
+      transform_table[new_state * class_num + class_id] =
+          target == DfaConfig::kInvalidStateIndex ? target
+                                                  : old_to_new[target];
+    }
+    word_attached_data[new_state] =
+        std::move(dfa_config_.word_attached_data[old_state]);
+    self_loop_ranges[new_state] = dfa_config_.self_loop_ranges[old_state];
+  }
+  dfa_config_.transform_table = std::move(transform_table);
+  dfa_config_.word_attached_data = std::move(word_attached_data);
+  dfa_config_.self_loop_ranges = std::move(self_loop_ranges);
+  root_transform_array_id_ = TransformArrayId(old_to_new[root_state]);
+  RecordPhase("ProfileGuidedStateRenumber",
+              std::chrono::steady_clock::now() - renumber_begin);
+  return true;
+#endif  // USE_LAZY_DFA
+}
+
+namespace {
+/// @brief 获取进程的峰值内存
+/// @return 返回峰值内存（字节），无法获取时返回0
+/// @note Windows下为峰值工作集，其它系统为峰值常驻内存
+size_t GetPeakMemoryBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS memory_counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters,
+                           sizeof(memory_counters))) [[likely]] {
+    return memory_counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) [[likely]] {
+#ifdef __APPLE__
+    // macOS下ru_maxrss单位为字节
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux下ru_maxrss单位为KB
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif  // __APPLE__
+  }
+  return 0;
+#endif  // _WIN32
+}
+
+/// @brief 将NFA规模输出为JSON对象
+/// @param[in] nfa_size ：NFA规模
+/// @return 返回JSON对象字符串
+std::string NfaSizeToJson(const NfaGenerator::NfaSize& nfa_size) {
+  return std::format(
+      "{{\"node_num\": {:}, \"conditional_transfer_num\": {:}, "
+      "\"conditionless_transfer_num\": {:}}}",
+      nfa_size.node_num, nfa_size.conditional_transfer_num,
+      nfa_size.conditionless_transfer_num);
+}
+}  // namespace
+
+void DfaGenerator::RecordPhase(const char* phase_name,
+                               std::chrono::steady_clock::duration phase_time) {
+  generation_report_.phases.push_back(GenerationReport::PhaseRecord{
+      phase_name, std::chrono::duration<double>(phase_time).count(),
+      GetPeakMemoryBytes()});
+}
+
+void DfaGenerator::SaveGenerationReport(
+    const std::string& report_file_output_path) const {
+  std::ofstream report_file(
+      report_file_output_path + frontend::common::kDfaGenerationReportFileName,
+      std::ios_base::out);
+  assert(report_file.is_open());
+  report_file << "{\n  \"phases\": [";
+  for (size_t i = 0; i < generation_report_.phases.size(); i++) {
+    const auto& phase = generation_report_.phases[i];
+    report_file << std::format(
+        "{:}\n    {{\"name\": \"{:}\", \"wall_seconds\": {:.6f}, "
+        "\"peak_memory_bytes\": {:}}}",
+        i == 0 ? "" : ",", phase.name, phase.wall_seconds,
+        phase.peak_memory_bytes);
+  }
+  report_file << "\n  ],\n";
+  report_file << std::format(
+      "  \"nfa_size_before_merge\": {:},\n"
+      "  \"nfa_size_after_merge\": {:},\n"
+      "  \"dfa_state_num_before_minimize\": {:},\n"
+      "  \"dfa_state_num_after_minimize\": {:},\n",
+      NfaSizeToJson(generation_report_.nfa_size_before_merge),
+      NfaSizeToJson(generation_report_.nfa_size_after_merge),
+      generation_report_.dfa_state_num_before_minimize,
+      generation_report_.dfa_state_num_after_minimize);
+  report_file << "  \"largest_nfa_set_sizes\": [";
+  for (size_t i = 0; i < generation_report_.largest_nfa_set_sizes.size(); i++) {
+    report_file << std::format("{:}{:}", i == 0 ? "" : ", ",
+                               generation_report_.largest_nfa_set_sizes[i]);
+  }
+  report_file << "]\n}\n";
+}
+
 void DfaGenerator::SaveConfig(
     const std::string& config_file_output_path) const {
   std::ofstream ofile(
@@ -223,4 +1445,126 @@ void DfaGenerator::SaveConfig(
   }
 }
 
+void DfaGenerator::SaveLexerSource(
+    [[maybe_unused]] const std::string& source_file_output_path) const {
+#ifdef USE_LAZY_DFA
+  LOG_WARNING("DfaGenerator",
+              "Lazy DFA doesn't construct DFA states, lexer source skipped")
+#else
+  using frontend::generator::syntax_generator::OperatorPriority;
+  std::ofstream ofile(
+      source_file_output_path + frontend::common::kDfaLexerSourceFileName,
+      std::ios_base::out);
+  assert(ofile.is_open());
+  const size_t state_num = dfa_config_.GetStateNum();
+  // 与仓库中其它源文件相同使用带BOM的UTF-8编码
+  ofile << "\xEF\xBB\xBF"
+           "// 由DfaGenerator::SaveLexerSource生成，请勿手动修改\n"
+           "#include \"Parser/DfaParser/generated_dfa_lexer.h\"\n\n"
+           "namespace frontend::parser::dfa_parser::generated_dfa_lexer {\n\n"
+           "using frontend::generator::syntax_generator::OperatorPriority;\n"
+           "using frontend::generator::syntax_generator::ProductionNodeId;\n"
+           "using frontend::generator::syntax_generator::ProductionNodeType;\n"
+           "using frontend::common::OperatorAssociatityType;\n\n";
+  // 状态转移部分
+  ofile << "const char* MatchWord(const char* character_now, "
+           "const char* input_end,\n"
+           "                      StateIndex* state) {\n"
+           "  // 最后一次到达的接受状态和此时单词的尾后字符，用于最长匹配\n"
+           "  StateIndex last_accepted_state = "
+           "DfaConfigType::kInvalidStateIndex;\n"
+           "  const char* last_accepted_end = character_now;\n";
+  ofile << std::format("  goto state_{:};\n",
+                       root_transform_array_id_.GetRawValue());
+  for (size_t state = 0; state < state_num; state++) {
+    // 停止转移时接受状态直接返回，非接受状态回退到最后一个接受状态
+    const bool accepting =
+        dfa_config_.word_attached_data[state].production_node_id.IsValid();
+    auto format_stop_statements = [accepting, state](const char* indent) {
+      return accepting ? std::format(
+                             "{0:}*state = {1:};\n"
+                             "{0:}return character_now;\n",
+                             indent, state)
+                       : std::format(
+                             "{0:}*state = last_accepted_state;\n"
+                             "{0:}return last_accepted_end;\n",
+                             indent);
+    };
+    ofile << std::format("state_{:}:\n", state);
+    if (accepting) {
+      ofile << std::format(
+          "  last_accepted_state = {:};\n"
+          "  last_accepted_end = character_now;\n",
+          state);
+    }
+    ofile << "  if (character_now == input_end) [[unlikely]] {\n"
+          << format_stop_statements("    ")
+          << "  }\n"
+             "  switch (static_cast<unsigned char>(*character_now)) {\n";
+    // 按转移到的状态分组输出case，相同目标只输出一次goto
+    std::map<DfaConfig::StateIndex, std::vector<size_t>> target_to_characters;
+    for (size_t character = 0; character < kCharNum; character++) {
+      DfaConfig::StateIndex next_state = dfa_config_.Transform(
+          static_cast<DfaConfig::StateIndex>(state),
+          static_cast<char>(character));
+      if (next_state != DfaConfig::kInvalidStateIndex) {
+        target_to_characters[next_state].push_back(character);
+      }
+    }
+    for (const auto& [next_state, characters] : target_to_characters) {
+      for (size_t character : characters) {
+        ofile << std::format("    case {:}:\n", character);
+      }
+      ofile << std::format(
+          "      ++character_now;\n"
+          "      goto state_{:};\n",
+          next_state);
+    }
+    ofile << "    default:\n"
+          << format_stop_statements("      ") << "  }\n";
+  }
+  ofile << "}\n\n";
+  // 单词附属数据部分
+  auto format_word_attached_data =
+      [](const WordAttachedData& word_attached_data) {
+        auto format_priority = [](OperatorPriority priority) {
+          return priority.IsValid()
+                     ? std::format("OperatorPriority({:})",
+                                   priority.GetRawValue())
+                     : std::string("OperatorPriority::InvalidId()");
+        };
+        return std::format(
+            "{{.production_node_id = {:},\n"
+            "     .node_type = static_cast<ProductionNodeType>({:}),\n"
+            "     .binary_operator_associate_type =\n"
+            "         static_cast<OperatorAssociatityType>({:}),\n"
+            "     .binary_operator_priority = {:},\n"
+            "     .unary_operator_associate_type =\n"
+            "         static_cast<OperatorAssociatityType>({:}),\n"
+            "     .unary_operator_priority = {:}}}",
+            word_attached_data.production_node_id.IsValid()
+                ? std::format(
+                      "ProductionNodeId({:})",
+                      word_attached_data.production_node_id.GetRawValue())
+                : std::string("ProductionNodeId::InvalidId()"),
+            static_cast<int>(word_attached_data.node_type),
+            static_cast<int>(word_attached_data.binary_operator_associate_type),
+            format_priority(word_attached_data.binary_operator_priority),
+            static_cast<int>(word_attached_data.unary_operator_associate_type),
+            format_priority(word_attached_data.unary_operator_priority));
+      };
+  ofile << std::format("const size_t kStateNum = {:};\n\n", state_num);
+  ofile << "const WordAttachedData kWordAttachedData[] = {\n";
+  for (const auto& word_attached_data : dfa_config_.word_attached_data) {
+    ofile << "    " << format_word_attached_data(word_attached_data)
+          << ",\n";
+  }
+  ofile << "};\n\n";
+  ofile << "const WordAttachedData kEndOfFileSavedData =\n    "
+        << format_word_attached_data(file_end_saved_data_) << ";\n\n";
+  ofile << "}  // namespace "
+           "frontend::parser::dfa_parser::generated_dfa_lexer\n";
+#endif  // USE_LAZY_DFA
+}
+
 }  // namespace frontend::generator::dfa_generator
\ No newline at end of file
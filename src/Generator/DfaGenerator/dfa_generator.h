@@ -4,16 +4,19 @@
 /// DFA配置生成器使用子集构造法在NFA配置基础上构建DFA配置以提高速度
 /// DFA Generator构建配置时先通过子集构造法生成中间节点（IntermediateDfaNode），
 /// 每个中间节点对应子集构造法中唯一的一个集合；然后通过中间节点构造DFA转移表
+/// 子集构造法中的集合使用压缩编号后的NFA节点的稠密位集合表示
+/// 定义USE_LAZY_DFA时不构建DFA，只保存压缩编号后的NFA（LazyDfaConfig），
+/// 由DfaParser在运行时按需构建DFA状态
 #ifndef GENERATOR_DFAGENERATOR_DFAGENERATOR_H_
 #define GENERATOR_DFAGENERATOR_DFAGENERATOR_H_
 
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/map.hpp>
+#include <chrono>
 
 #include "Common/common.h"
 #include "Common/id_wrapper.h"
 #include "Common/object_manager.h"
-#include "Common/unordered_struct_manager.h"
 #include "Generator/export_types.h"
 #include "NfaGenerator/nfa_generator.h"
 
@@ -30,19 +33,6 @@ class DfaGenerator {
  public:
   /// @brief Nfa节点ID
   using NfaNodeId = NfaGenerator::NfaNodeId;
-  /// @brief 子集构造法使用的集合的类型
-  using SetType = std::unordered_set<NfaNodeId>;
-  /// @class UnorderedSetHasher dfa_generator.h
-  /// @brief 哈希SetType集合的类，用于实例化UnorderedStructManager
-  struct UnorderedSetHasher {
-    size_t operator()(const SetType& set) const {
-      size_t result = 1;
-      for (const auto& item : set) {
-        result *= item;
-      }
-      return result;
-    }
-  };
   /// @brief 尾节点数据
   using TailNodeData = NfaGenerator::TailNodeData;
   /// @brief 尾节点优先级
@@ -54,14 +44,41 @@ class DfaGenerator {
   using WordPriority = nfa_generator::WordPriority;
   /// @brief 解析出单词后随单词返回的附属数据
   using WordAttachedData = nfa_generator::WordAttachedData;
-  /// @brief 管理子集构造法使用的集合的结构
-  using SetManagerType =
-      frontend::common::UnorderedStructManager<SetType, UnorderedSetHasher>;
-  /// @brief 子集构造法使用的集合的ID
-  using SetId = SetManagerType::ObjectId;
   /// @brief DFA中间节点ID
   using IntermediateNodeId = ObjectManager<IntermediateDfaNode>::ObjectId;
 
+  /// @class GenerationReport dfa_generator.h
+  /// @brief DFA配置生成过程的统计数据
+  /// @details 用于分析生成DFA配置时间和内存的瓶颈，通过SaveGenerationReport
+  /// 输出为JSON
+  struct GenerationReport {
+    /// @class PhaseRecord dfa_generator.h
+    /// @brief 一个生成阶段的耗时和内存
+    struct PhaseRecord {
+      /// @brief 阶段名
+      std::string name;
+      /// @brief 阶段耗时（秒）
+      double wall_seconds;
+      /// @brief 阶段结束时进程的峰值内存（字节）
+      /// @note 峰值内存只增不减，相邻阶段的差值为该阶段新增的峰值
+      size_t peak_memory_bytes;
+    };
+
+    /// @brief 按执行顺序排列的各阶段记录
+    /// @note RegexConstruct阶段为所有AddWord和AddRegexpression耗时之和
+    std::vector<PhaseRecord> phases;
+    /// @brief 合并优化前的NFA规模
+    NfaGenerator::NfaSize nfa_size_before_merge;
+    /// @brief 合并优化后的NFA规模
+    NfaGenerator::NfaSize nfa_size_after_merge;
+    /// @brief 最小化前的DFA状态数（子集构造得到的集合数）
+    size_t dfa_state_num_before_minimize = 0;
+    /// @brief 最小化后的DFA状态数
+    size_t dfa_state_num_after_minimize = 0;
+    /// @brief 子集构造中成员最多的若干个集合的成员数，从大到小排列
+    std::vector<size_t> largest_nfa_set_sizes;
+  };
+
   DfaGenerator() = default;
   DfaGenerator(const DfaGenerator&) = delete;
   DfaGenerator(DfaGenerator&&) = delete;
@@ -105,12 +122,49 @@ class DfaGenerator {
     return file_end_saved_data_;
   }
   /// @brief 构建DFA配置
+  /// @param[in] thread_num ：子集构造最多使用的线程数（包括调用线程）
   /// @note 该函数仅生成DFA配置，不会自动保存配置到文件
-  bool DfaConstruct();
+  /// 生成的DFA配置与thread_num无关
+  /// 定义USE_LAZY_DFA时只压缩NFA，不进行子集构造和最小化
+  bool DfaConstruct(size_t thread_num = 1);
+  /// @brief 根据有代表性的语料中各状态的访问次数重新编号DFA状态
+  /// @param[in] corpus_file_path ：语料文件路径
+  /// @return 返回是否成功重新编号
+  /// @retval false ：无法打开语料文件或定义了USE_LAZY_DFA
+  /// @details
+  /// 1.与DfaParser相同跳过空白字符后按最长匹配划分单词，统计每个状态被到达的
+  /// 次数，无法识别的字符跳过一个字节
+  /// 2.按访问次数从大到小重新编号（次数相同时保持原有顺序），使根状态、
+  /// 标识符等热点状态在转移表开头连续存储，占用尽可能少的缓存行
+  /// 3.同时重新排列转移表、单词附属数据和自循环字节集合，不改变识别的单词
+  /// @note 该函数在DfaConstruct后、SaveConfig和SaveLexerSource前调用
+  bool ProfileGuidedStateRenumber(const std::string& corpus_file_path);
   /// @brief 保存DFA配置
   /// @param[in] DFA配置保存路径（不含文件名，以'/'结尾）
   /// @details DFA配置输出文件名为frontend::common::kDfaConfigFileName
   void SaveConfig(const std::string& config_file_output_path = "./") const;
+  /// @brief 将DFA配置输出为直接编码的C++词法分析器源文件
+  /// @param[in] source_file_output_path ：源文件保存路径（不含文件名，以'/'结尾）
+  /// @details
+  /// 1.源文件名为frontend::common::kDfaLexerSourceFileName
+  /// 2.每个DFA状态对应一个标签，在标签处对输入字符switch后goto到下一个状态，
+  /// 实现Parser/DfaParser/generated_dfa_lexer.h声明的接口
+  /// 3.Parser构建时指定GENERATED_DFA_LEXER_SOURCE为该文件即可代替DFA转移表，
+  /// 运行时不再需要读取kDfaConfigFileName
+  /// @note 该函数在DfaConstruct后调用
+  /// 定义USE_LAZY_DFA时没有完整的DFA，不生成源文件
+  void SaveLexerSource(const std::string& source_file_output_path = "./") const;
+  /// @brief 获取DFA配置生成过程的统计数据
+  /// @return 返回统计数据的const引用
+  const GenerationReport& GetGenerationReport() const {
+    return generation_report_;
+  }
+  /// @brief 将DFA配置生成过程的统计数据保存为JSON
+  /// @param[in] report_file_output_path ：报告保存路径（不含文件名，以'/'结尾）
+  /// @details 报告文件名为frontend::common::kDfaGenerationReportFileName
+  /// @note 该函数在DfaConstruct后调用
+  void SaveGenerationReport(
+      const std::string& report_file_output_path = "./") const;
 
  private:
   /// @brief 声明友元，允许序列化类访问成员
@@ -131,8 +185,17 @@ class DfaGenerator {
   /// @attention 该函数应由boost库调用而非手动调用
   template <class Archive>
   void save(Archive& ar, const unsigned int version) const {
+#ifdef USE_LAZY_DFA
+    ar << lazy_dfa_config_;
+#else
+#ifdef USE_COMB_DFA_TABLE
+    const CombDfaConfig comb_dfa_config = CombDfaConfigConstruct();
+    ar << comb_dfa_config;
+#else
     ar << dfa_config_;
+#endif  // USE_COMB_DFA_TABLE
     ar << root_transform_array_id_;
+#endif  // USE_LAZY_DFA
     ar << file_end_saved_data_;
   }
   /// 分割save和load操作，DFA配置生成器只能执行save操作，不能执行load操作
@@ -143,11 +206,10 @@ class DfaGenerator {
   /// @details
   /// 中间节点与子集构造法的集合一一对应，每个节点存储一个条件转移表
   struct IntermediateDfaNode {
-    template <class AttachedData>
-    IntermediateDfaNode(SetId handler = SetId::InvalidId(),
-                        AttachedData&& word_attached_data_ = WordAttachedData())
-        : word_attached_data(std::forward<AttachedData>(word_attached_data_)),
-          set_handler(handler) {
+    template <class AttachedData = WordAttachedData>
+    explicit IntermediateDfaNode(
+        AttachedData&& word_attached_data_ = WordAttachedData())
+        : word_attached_data(std::forward<AttachedData>(word_attached_data_)) {
       SetAllUntransable();
     }
 
@@ -155,9 +217,6 @@ class DfaGenerator {
     void SetAllUntransable() {
       forward_nodes.fill(IntermediateNodeId::InvalidId());
     }
-    /// @brief 获取该节点对应集合的ID
-    /// @return 返回该节点对应集合的ID
-    SetId GetSetHandler() const { return set_handler; }
     /// @brief 设置该节点对应单词的数据
     /// @param[in] data ：对应单词数据
     /// @note 该函数仅接受WordAttachedData的const引用和右值引用
@@ -171,13 +230,68 @@ class DfaGenerator {
     TransformArrayManager<IntermediateNodeId> forward_nodes;
     /// @brief 该节点对应单词的数据
     WordAttachedData word_attached_data;
-    /// 该节点对应的集合ID
-    SetId set_handler;
   };
 
+  /// @brief 给可达的NFA节点和闭包分配连续的压缩编号
+  /// @return 返回压缩编号后的NFA
+  /// @details
+  /// 从NFA头结点出发，每个闭包只调用一次NfaGenerator::Closure，闭包内
+  /// 最高优先级的单词代表该闭包；同时用所有条件转移范围的边界划分字节等价类
+  /// @note 该函数在NfaGenerator::MergeOptimization后调用
+  LazyDfaConfig NfaCompact();
+  /// @brief 使用子集构造法生成所有中间节点
+  /// @param[in] thread_num ：最多使用的线程数（包括调用线程）
+  /// @details
+  /// 1.使用NfaCompact给可达的NFA节点分配连续的压缩编号，每个闭包存储为
+  /// 位集合
+  /// 2.集合使用位集合表示，通过64位哈希和开放寻址表查找已存在的集合
+  /// 3.每个集合只遍历一次成员的条件转移，将转移到的闭包按字符并入对应的集合，
+  /// 不再对每个字符分别调用NfaGenerator::Goto
+  /// 4.NFA条件转移按字符范围存储，集合成员所有范围的边界将字符划分为基本区间，
+  /// 每个基本区间只计算一次转移到的集合
+  /// 5.thread_num > 1时多个线程使用工作窃取的方式处理待处理集合，集合按哈希值
+  /// 分片存储，每个分片单独加锁
+  /// 6.所有集合处理完成后从初始集合出发广度优先遍历，按发现顺序创建中间节点，
+  /// 因此中间节点ID和最终配置与单线程处理时完全相同
+  /// @note 该函数填写root_intermediate_node_id_
+  void SubsetConstruct(size_t thread_num);
+
   /// @brief 构建最小化DFA
   /// @note 该函数在DfaConstruct操作后调用，合并相同转移项并填充DFA配置表
+  /// 填充配置表时按字节等价类压缩转移表
+  /// 定义USE_HOPCROFT_DFA_MINIMIZE时使用HopcroftClassify合并节点，
+  /// 否则使用IntermediateNodeClassify
   bool DfaMinimize();
+  /// @brief 计算字节等价类并填写压缩后的转移表
+  /// @param[in] transform_columns ：未压缩的转移表，下标为字符*状态数+状态编号
+  /// @details
+  /// 在所有状态下转移结果都相同的字符属于同一个等价类，每个等价类在转移表中
+  /// 只存储一列；该函数填写dfa_config_的char_to_class、class_num和
+  /// transform_table
+  /// @note 字符下标为static_cast<unsigned char>(c)，状态数为transform_array_size_
+  void ByteEquivalenceClassify(
+      const std::vector<DfaConfig::StateIndex>& transform_columns);
+  /// @brief 计算每个状态转移到自身的字节集合
+  /// @details
+  /// 将转移到自身的字节按unsigned char顺序合并为区间，区间数目不超过
+  /// ByteRanges::kMaxRangeNum时填写dfa_config_.self_loop_ranges，否则存储空集合
+  /// @note 该函数在ByteEquivalenceClassify后调用
+  void SelfLoopByteRangesConstruct();
+  /// @brief 使用行位移压缩转移表
+  /// @return 返回压缩后的DFA配置
+  /// @details
+  /// 1.依次为每个状态在之前的若干个状态中选择转移结果不同的条目最少的状态
+  /// 作为默认状态，不同的条目数不少于可以转移的条目数时不使用默认状态；
+  /// 默认状态链长度不超过kMaxDefaultStateChainLength
+  /// 2.按需要存储的条目数从多到少依次将每个状态的行放到不与已有条目冲突的
+  /// 最小起始下标处（首次适应）
+  /// @note 该函数在DfaMinimize后调用，不修改dfa_config_
+  CombDfaConfig CombDfaConfigConstruct() const;
+  /// @brief 记录一个生成阶段的耗时和当前进程的峰值内存
+  /// @param[in] phase_name ：阶段名
+  /// @param[in] phase_time ：阶段耗时
+  void RecordPhase(const char* phase_name,
+                   std::chrono::steady_clock::duration phase_time);
   /// @brief 获取中间节点引用
   /// @param[in] id ：中间节点ID
   /// @return 返回对应的中间节点引用
@@ -192,27 +306,13 @@ class DfaGenerator {
   const IntermediateDfaNode& GetIntermediateNode(IntermediateNodeId id) const {
     return node_manager_intermediate_node_.GetObject(id);
   }
-  /// @brief 获取子集构造法的集合的引用
-  /// @param[in] set_id ：集合ID
-  /// @return 返回集合的引用
-  /// @note set_id必须对应已存在的集合
-  SetType& GetSetObject(SetId set_id) {
-    return node_manager_set_.GetObject(set_id);
-  }
-  /// @brief 获取NFA节点集合在给定字符下的转移结果
-  /// @param[in] set_src ：转移起点的NFA节点ID的集合
-  /// @param[in] c_transform ：转移条件
-  /// @return 返回值前半部分为对应中间节点句柄，后半部分表示是否新创建了集合
-  /// @retval std::pair(IntermediateNodeId::InvalidId(), false)
-  /// ：该集合在给定条件下无法转移
-  std::pair<IntermediateNodeId, bool> SetGoto(SetId set_src, char c_transform);
   /// @brief 查询DFA中间节点在给定条件下的转移情况
   /// @param[in] dfa_src ：转移起点的DFA中间节点
   /// @param[in] c_transform ：转移条件
   /// @return 返回转移到的DFA中间节点ID
   /// @retval IntermediateNodeId::InvalidId()
   /// ：该节点在c_transform条件下无法转移
-  /// @note 该函数仅查询，SetGoto如果不存在会创建新集合和中间节点
+  /// @note 该函数仅查询
   IntermediateNodeId IntermediateGoto(IntermediateNodeId dfa_src,
                                       char c_transform) const;
   /// @brief 设置DFA中间节点条件转移
@@ -226,17 +326,6 @@ class DfaGenerator {
   bool SetIntermediateNodeTransform(IntermediateNodeId node_intermediate_src,
                                     char c_transform,
                                     IntermediateNodeId node_intermediate_dst);
-  /// @brief 获取集合对应的中间节点ID，如果不存在则创建新的中间节点
-  /// @param[in] uset ：获取对应中间节点的集合
-  /// @param[in] word_attached_data ：如果创建中间节点则该中间节点使用该单词数据
-  /// @return
-  /// 返回获取到的中间节点ID和是否新插入该集合（是否新建中间节点）
-  /// @note IntermediateNodeSet仅支持SetType的const左值引用或右值引用
-  template <class IntermediateNodeSet>
-  std::pair<IntermediateNodeId, bool> InOrInsert(
-      IntermediateNodeSet&& uset,
-      WordAttachedData&& word_attached_data = WordAttachedData());
-
   /// @brief 对中间节点进行分类
   /// @param[in] node_ids ：待分类的节点集合
   /// @param[in] c_transform ：本轮分类使用的转移字符
@@ -254,13 +343,37 @@ class DfaGenerator {
   /// @attention node_ids所有元素不允许重复
   void IntermediateNodeClassify(std::list<IntermediateNodeId>&& node_ids,
                                 char c_transform = CHAR_MIN);
+  /// @brief 使用Hopcroft划分细化算法对中间节点进行分类
+  /// @details
+  /// 1.先将在所有节点下转移结果都相同的字符合并为一类，之后每类只处理一次
+  /// 2.添加一个死状态补全DFA，初始时按单词数据划分所有状态，之后用工作表中
+  /// 的块在每类字符下的原像分裂其它块，原块在工作表中时两部分都加入工作表，
+  /// 否则只加入较小的部分，时间复杂度O(n·k·log n)
+  /// 3.划分和逆向转移表均存储在连续数组中，不按字符递归也不逐层新建容器
+  /// @note 结果为最小DFA，与死状态等价（无法到达接受状态）的节点被删除
+  /// 该函数会填写intermediate_node_to_final_node_和transform_array_size_
+  void HopcroftClassify();
+#ifdef _DEBUG
+  /// @brief 检查HopcroftClassify的结果
+  /// @details
+  /// 1.检查划分是同余关系（合并后的DFA接受相同的单词）
+  /// 2.检查与IntermediateNodeClassify的结果同构：状态数相同，条目之间存在双射，
+  /// 对应条目的单词数据相同且在任何字符下都转移到对应的条目
+  void CheckHopcroftClassify();
+#endif  // _DEBUG
 
   /// @brief DFA配置
-  /// @note 写入配置文件
-  DfaConfigType dfa_config_;
+  /// @note 写入配置文件，定义USE_COMB_DFA_TABLE时压缩为CombDfaConfig后写入
+  DfaConfig dfa_config_;
   /// @brief DFA转移表初始条目序号
   /// @note 写入配置文件
   TransformArrayId root_transform_array_id_;
+#ifdef USE_LAZY_DFA
+  /// @brief 压缩编号后的NFA
+  /// @note 定义USE_LAZY_DFA时代替dfa_config_和root_transform_array_id_
+  /// 写入配置文件
+  LazyDfaConfig lazy_dfa_config_;
+#endif  // USE_LAZY_DFA
   /// @brief 遇到文件尾时返回的数据
   /// @note 写入配置文件
   WordAttachedData file_end_saved_data_;
@@ -271,37 +384,18 @@ class DfaGenerator {
   IntermediateNodeId root_intermediate_node_id_;
   /// @brief DFA转移表条目数
   size_t transform_array_size_ = 0;
+  /// @brief 所有AddWord和AddRegexpression的耗时之和
+  std::chrono::steady_clock::duration regex_construct_time_ =
+      std::chrono::steady_clock::duration::zero();
+  /// @brief DFA配置生成过程的统计数据
+  GenerationReport generation_report_;
 
   /// @brief 存储DFA中间节点到转移表条目的映射
   std::unordered_map<IntermediateNodeId, TransformArrayId>
       intermediate_node_to_final_node_;
   /// @brief 存储中间节点
   ObjectManager<IntermediateDfaNode> node_manager_intermediate_node_;
-  /// @brief 管理中间节点对应的集合
-  SetManagerType node_manager_set_;
-  /// @brief 存储集合ID到中间节点ID的映射
-  std::unordered_map<SetId, IntermediateNodeId> setid_to_intermediate_nodeid_;
 };
 
-template <class IntermediateNodeSet>
-inline std::pair<DfaGenerator::IntermediateNodeId, bool>
-DfaGenerator::InOrInsert(IntermediateNodeSet&& uset,
-                         WordAttachedData&& word_attached_data) {
-  auto [setid, inserted] =
-      node_manager_set_.EmplaceObject(std::forward<IntermediateNodeSet>(uset));
-  IntermediateNodeId intermediate_node_id = IntermediateNodeId::InvalidId();
-  if (inserted) {
-    intermediate_node_id = node_manager_intermediate_node_.EmplaceObject(
-        setid, std::move(word_attached_data));
-    setid_to_intermediate_nodeid_.insert(
-        std::make_pair(setid, intermediate_node_id));
-  } else {
-    auto iter = setid_to_intermediate_nodeid_.find(setid);
-    assert(iter != setid_to_intermediate_nodeid_.end());
-    intermediate_node_id = iter->second;
-  }
-  return std::make_pair(intermediate_node_id, inserted);
-}
-
 }  // namespace frontend::generator::dfa_generator
 #endif  /// !GENERATOR_DFAGENERATOR_DFAGENERATOR_H_
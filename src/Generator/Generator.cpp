@@ -4,9 +4,14 @@
 #include "SyntaxGenerator/syntax_generator.h"
 #include "SyntaxGenerator/syntax_generator_classes_register.h"
 
-int main() {
-  frontend::generator::syntax_generator::SyntaxGenerator syntax_generator;
-  syntax_generator.ConstructSyntaxConfig();
+/// 可选的第一个参数为有代表性的语料文件路径，用于重新编号DFA状态
+int main(int argc, char** argv) {
+  using frontend::generator::syntax_generator::SyntaxGenerator;
+  SyntaxGenerator syntax_generator;
+  syntax_generator.ConstructSyntaxConfig(
+      SyntaxGenerator::SyntaxAnalysisTableConstructMode::
+          kSpreadLookForwardSymbol,
+      argc > 1 ? argv[1] : std::string());
 }
 
 /// 运行程序: Ctrl + F5 或调试 >“开始执行(不调试)”菜单
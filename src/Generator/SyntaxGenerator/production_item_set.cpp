@@ -1,7 +1,63 @@
 ﻿#include "production_item_set.h"
 
+#if defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRONTEND_FORWARD_NODE_BITSET_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace frontend::generator::syntax_generator {
 
+bool ForwardNodeBitset::UnionWith(const ForwardNodeBitset& bitset,
+                                  ForwardNodeBitset* added_bitset) {
+  assert(words_.size() == bitset.words_.size());
+  assert(added_bitset == nullptr ||
+         added_bitset->words_.size() == words_.size());
+  WordType* target_words = words_.data();
+  const WordType* source_words = bitset.words_.data();
+  WordType* added_words =
+      added_bitset == nullptr ? nullptr : added_bitset->words_.data();
+  const size_t word_num = words_.size();
+  size_t word_index = 0;
+  // 记录合并后新增的位，最后统一判断是否添加了新的向前看符号
+  WordType changed_bits = 0;
+#ifdef FRONTEND_FORWARD_NODE_BITSET_SSE2
+  static_assert(kWordAlignment * sizeof(WordType) == sizeof(__m128i));
+  __m128i changed_block = _mm_setzero_si128();
+  for (; word_index < word_num; word_index += kWordAlignment) {
+    __m128i* target_block =
+        reinterpret_cast<__m128i*>(target_words + word_index);
+    __m128i old_block = _mm_loadu_si128(target_block);
+    __m128i new_block = _mm_or_si128(
+        old_block, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                       source_words + word_index)));
+    __m128i added_block = _mm_xor_si128(old_block, new_block);
+    changed_block = _mm_or_si128(changed_block, added_block);
+    _mm_storeu_si128(target_block, new_block);
+    if (added_words != nullptr) {
+      __m128i* added_target_block =
+          reinterpret_cast<__m128i*>(added_words + word_index);
+      _mm_storeu_si128(
+          added_target_block,
+          _mm_or_si128(_mm_loadu_si128(added_target_block), added_block));
+    }
+  }
+  // 新增的位全部为0时每个字节都与0相等
+  changed_bits = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                     changed_block, _mm_setzero_si128())) != 0xFFFF;
+#endif  // FRONTEND_FORWARD_NODE_BITSET_SSE2
+  for (; word_index < word_num; word_index++) {
+    WordType new_word = target_words[word_index] | source_words[word_index];
+    WordType added_word = new_word ^ target_words[word_index];
+    changed_bits |= added_word;
+    target_words[word_index] = new_word;
+    if (added_words != nullptr) {
+      added_words[word_index] |= added_word;
+    }
+  }
+  return changed_bits != 0;
+}
+
 ProductionItemSet& ProductionItemSet::operator=(
     ProductionItemSet&& production_item_set) {
   production_item_set_closure_available_ =
@@ -12,15 +68,37 @@ ProductionItemSet& ProductionItemSet::operator=(
       std::move(production_item_set.syntax_analysis_table_entry_id_);
   item_and_forward_node_ids_ =
       std::move(production_item_set.item_and_forward_node_ids_);
+  pending_forward_node_ids_ =
+      std::move(production_item_set.pending_forward_node_ids_);
   return *this;
 }
 
 void ProductionItemSet::ClearNotMainItem() {
   ProductionItemAndForwardNodesContainer new_container;
-  for (auto& main_item_iter : GetMainItemIters()) {
-    main_item_iter = new_container.insert(*main_item_iter).first;
+  for (const auto& main_item_iter : GetMainItemIters()) {
+    new_container.insert(*main_item_iter);
   }
   item_and_forward_node_ids_.swap(new_container);
+  // 迭代器与容器对象绑定，交换后需要重新获取指向核心项的迭代器
+  for (auto& main_item_iter : GetMainItemIters()) {
+    main_item_iter = item_and_forward_node_ids_.find(main_item_iter->first);
+  }
+}
+
+ProductionItemSet::ForwardNodesContainer
+ProductionItemSet::SpreadForwardNodesToItem(
+    const ProductionItem& item, const ForwardNodesContainer& forward_node_ids) {
+  auto iter = item_and_forward_node_ids_.find(item);
+  if (iter == item_and_forward_node_ids_.end()) {
+    // 已经求过闭包的项集不能添加新项
+    assert(!IsClosureAvailable());
+    item_and_forward_node_ids_.emplace(item, forward_node_ids);
+    return forward_node_ids;
+  }
+  ForwardNodesContainer added_forward_node_ids =
+      forward_node_ids.CreateEmptyWithSameSize();
+  AddForwardNodes(iter, forward_node_ids, &added_forward_node_ids);
+  return added_forward_node_ids;
 }
 
 bool ProductionItemSet::IsMainItem(const ProductionItem& item) {
@@ -33,7 +111,7 @@ bool ProductionItemSet::IsMainItem(const ProductionItem& item) {
 }
 
 void ProductionItemSet::SetMainItem(
-    ProductionItemAndForwardNodesContainer::const_iterator& item_iter) {
+    ProductionItemAndForwardNodesContainer::const_iterator item_iter) {
 #ifdef _DEBUG
   // 不允许重复设置已有的核心项为核心项
   for (const auto& main_item_already_in : GetMainItemIters()) {
@@ -43,4 +121,34 @@ void ProductionItemSet::SetMainItem(
   main_items_.emplace_back(item_iter);
   SetClosureNotAvailable();
 }
+
+size_t ProductionItemSet::ProductionItemAndForwardNodesContainer::FindSlotIndex(
+    PackedProductionItem packed_item) const {
+  assert(!slots_.empty());
+  const size_t slot_index_mask = slots_.size() - 1;
+  size_t slot_index = HashPackedProductionItem(packed_item) & slot_index_mask;
+  // 线性探测，直到找到该项或遇到空槽位
+  while (slots_[slot_index].item_index != kInvalidItemIndex &&
+         slots_[slot_index].packed_item != packed_item) {
+    slot_index = (slot_index + 1) & slot_index_mask;
+  }
+  return slot_index;
+}
+
+void ProductionItemSet::ProductionItemAndForwardNodesContainer::Rehash(
+    size_t slot_num) {
+  // 槽位数必须是2的幂
+  assert(slot_num != 0 && (slot_num & (slot_num - 1)) == 0);
+  assert(slot_num > items_.size());
+  slots_.assign(slot_num, Slot());
+  // 存储数组中没有重复项，直接按顺序重新插入所有项
+  for (size_t item_index = 0; item_index < items_.size(); item_index++) {
+    PackedProductionItem packed_item =
+        PackProductionItem(items_[item_index].first);
+    Slot& slot = slots_[FindSlotIndex(packed_item)];
+    assert(slot.item_index == kInvalidItemIndex);
+    slot.packed_item = packed_item;
+    slot.item_index = item_index;
+  }
+}
 }  // namespace frontend::generator::syntax_generator
\ No newline at end of file
@@ -5,10 +5,109 @@
 #ifndef GENERATOR_SYNTAXGENERATOR_PRODUCTION_ITEM_SET_H_
 #define GENERATOR_SYNTAXGENERATOR_PRODUCTION_ITEM_SET_H_
 
-#include <unordered_set>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
 #include "Generator/export_types.h"
 namespace frontend::generator::syntax_generator {
+/// @class ForwardNodeBitset production_item_set.h
+/// @brief 存储向前看符号的定长位集
+/// @details
+/// 向前看符号只能是终结节点、运算符节点和文件尾节点，SyntaxGenerator将这些
+/// 节点重新编号为[0,向前看符号总数)的连续下标，每一位代表一个向前看符号
+/// 同一个语法分析机配置生成器创建的位集位数都相同，合并位集时使用SIMD指令
+/// @note 位集不存储节点ID，下标与节点ID的转换由SyntaxGenerator负责
+class ForwardNodeBitset {
+ public:
+  /// @brief 存储位的字类型
+  using WordType = uint64_t;
+  /// @brief 每个字的位数
+  static constexpr size_t kWordBits = sizeof(WordType) * 8;
+  /// @brief 字数对齐到该值的整数倍，保证合并时可以整块使用SIMD指令
+  static constexpr size_t kWordAlignment = 2;
+
+  ForwardNodeBitset() = default;
+  /// @param[in] bit_num ：位集位数（向前看符号总数）
+  explicit ForwardNodeBitset(size_t bit_num)
+      : words_((bit_num + kWordBits * kWordAlignment - 1) /
+               (kWordBits * kWordAlignment) * kWordAlignment) {}
+
+  /// @brief 设置一个向前看符号
+  /// @param[in] index ：向前看符号下标
+  /// @return 返回是否添加了新的向前看符号
+  bool Set(size_t index) {
+    assert(index / kWordBits < words_.size());
+    WordType& word = words_[index / kWordBits];
+    WordType mask = WordType(1) << (index % kWordBits);
+    bool inserted = !(word & mask);
+    word |= mask;
+    return inserted;
+  }
+  /// @brief 判断是否存在给定向前看符号
+  /// @param[in] index ：向前看符号下标
+  bool Test(size_t index) const {
+    assert(index / kWordBits < words_.size());
+    return words_[index / kWordBits] & (WordType(1) << (index % kWordBits));
+  }
+  /// @brief 将另一个位集合并到该位集
+  /// @param[in] bitset ：待合并的位集
+  /// @param[out] added_bitset ：存储合并时新增的向前看符号，不会清空已有内容
+  /// @return 返回是否添加了新的向前看符号
+  /// @note 所有位集的位数必须相同，added_bitset可以为nullptr
+  bool UnionWith(const ForwardNodeBitset& bitset,
+                 ForwardNodeBitset* added_bitset = nullptr);
+  /// @brief 创建位数与该位集相同的空位集
+  /// @return 返回创建的空位集
+  ForwardNodeBitset CreateEmptyWithSameSize() const {
+    ForwardNodeBitset bitset;
+    bitset.words_.resize(words_.size());
+    return bitset;
+  }
+  /// @brief 判断位集是否为空
+  bool Empty() const {
+    for (WordType word : words_) {
+      if (word != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+  /// @brief 获取向前看符号个数
+  size_t Count() const {
+    size_t count = 0;
+    for (WordType word : words_) {
+      count += std::popcount(word);
+    }
+    return count;
+  }
+  /// @brief 按下标升序遍历所有向前看符号
+  /// @param[in] callback ：对每个向前看符号下标调用的函数，参数为size_t
+  template <class Callback>
+  void ForEach(Callback&& callback) const {
+    for (size_t word_index = 0; word_index < words_.size(); word_index++) {
+      WordType word = words_[word_index];
+      while (word != 0) {
+        callback(word_index * kWordBits + std::countr_zero(word));
+        // 清除最低位的1
+        word &= word - 1;
+      }
+    }
+  }
+  bool operator==(const ForwardNodeBitset& bitset) const {
+    return words_ == bitset.words_;
+  }
+  bool operator!=(const ForwardNodeBitset& bitset) const {
+    return !operator==(bitset);
+  }
+
+ private:
+  /// @brief 存储位的字，字数为kWordAlignment的整数倍
+  std::vector<WordType> words_;
+};
+
 /// @class ProductionItemSet production_item_set.h
 /// @brief 存储项集与向前看符号的类
 class ProductionItemSet {
@@ -17,21 +116,239 @@ class ProductionItemSet {
   /// 产生式节点ID，产生式体ID，下一个移入的单词的位置
   using ProductionItem =
       std::tuple<ProductionNodeId, ProductionBodyId, NextWordToShiftIndex>;
+  /// @brief 压缩到64位整数中的项
+  using PackedProductionItem = uint64_t;
   /// @brief 向前看符号容器
-  using ForwardNodesContainer = std::unordered_set<ProductionNodeId>;
+  using ForwardNodesContainer = ForwardNodeBitset;
+
+  /// @brief 压缩项时产生式节点ID占用的位数
+  static constexpr size_t kProductionNodeIdBits = 32;
+  /// @brief 压缩项时产生式体ID占用的位数
+  static constexpr size_t kProductionBodyIdBits = 16;
+  /// @brief 压缩项时下一个移入的单词的位置占用的位数
+  static constexpr size_t kNextWordToShiftIndexBits = 16;
+  static_assert(kProductionNodeIdBits + kProductionBodyIdBits +
+                    kNextWordToShiftIndexBits ==
+                sizeof(PackedProductionItem) * 8);
+
+  /// @brief 将项压缩为一个64位整数
+  /// @param[in] production_item ：待压缩的项
+  /// @return 返回压缩后的项
+  /// @details
+  /// 从高位到低位依次存储产生式节点ID、产生式体ID、下一个移入的单词的位置
+  /// 不同的项压缩后的结果一定不同
+  static PackedProductionItem PackProductionItem(
+      const ProductionItem& production_item) {
+    const auto& [production_node_id, production_body_id,
+                 next_word_to_shift_index] = production_item;
+    assert(production_node_id.GetRawValue() <
+           (size_t(1) << kProductionNodeIdBits));
+    assert(production_body_id.GetRawValue() <
+           (size_t(1) << kProductionBodyIdBits));
+    assert(next_word_to_shift_index.GetRawValue() <
+           (size_t(1) << kNextWordToShiftIndexBits));
+    return (PackedProductionItem(production_node_id.GetRawValue())
+            << (kProductionBodyIdBits + kNextWordToShiftIndexBits)) |
+           (PackedProductionItem(production_body_id.GetRawValue())
+            << kNextWordToShiftIndexBits) |
+           PackedProductionItem(next_word_to_shift_index.GetRawValue());
+  }
+  /// @brief 哈希压缩后的项
+  /// @param[in] packed_production_item ：压缩后的项
+  /// @return 返回哈希值
+  /// @details
+  /// 使用MurmurHash3的64位终结混合函数，输入的每一位都会影响输出的全部位，
+  /// 哈希值的低位可以直接用作开放定址哈希表的下标
+  static size_t HashPackedProductionItem(
+      PackedProductionItem packed_production_item) {
+    packed_production_item ^= packed_production_item >> 33;
+    packed_production_item *= 0xff51afd7ed558ccdULL;
+    packed_production_item ^= packed_production_item >> 33;
+    packed_production_item *= 0xc4ceb9fe1a85ec53ULL;
+    packed_production_item ^= packed_production_item >> 33;
+    return static_cast<size_t>(packed_production_item);
+  }
   /// @brief 哈希ProductionItem的类
   /// 通过该类允许ProductionItem可以作为std::unordered_map键值
   struct ProductionItemHasher {
     size_t operator()(const ProductionItem& production_item) const {
-      return std::get<ProductionNodeId>(production_item) *
-             std::get<ProductionBodyId>(production_item) *
-             std::get<NextWordToShiftIndex>(production_item);
+      return HashPackedProductionItem(PackProductionItem(production_item));
     }
   };
+
+  /// @class ProductionItemAndForwardNodesContainer production_item_set.h
   /// @brief 存储项和向前看节点的容器
-  using ProductionItemAndForwardNodesContainer =
-      std::unordered_map<ProductionItem, ForwardNodesContainer,
-                         ProductionItemHasher>;
+  /// @details
+  /// 项和向前看节点按插入顺序连续存储，通过开放定址（线性探测）的哈希表
+  /// 查找项，哈希表的槽位中存储压缩后的项和该项在存储数组中的下标
+  /// 接口与std::unordered_map相同的子集，不支持删除单个项
+  /// @note
+  /// 迭代器存储容器地址和项的下标，插入新项后原有迭代器仍然有效；
+  /// 交换或移动容器后迭代器仍指向原来的容器对象
+  class ProductionItemAndForwardNodesContainer {
+   public:
+    using key_type = ProductionItem;
+    using mapped_type = ForwardNodesContainer;
+    using value_type = std::pair<const ProductionItem, ForwardNodesContainer>;
+
+    /// @class IteratorBase production_item_set.h
+    /// @brief 容器的迭代器
+    /// @param[in] is_const ：是否为const_iterator
+    template <bool is_const>
+    class IteratorBase {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = ProductionItemAndForwardNodesContainer::value_type;
+      using difference_type = std::ptrdiff_t;
+      using pointer =
+          std::conditional_t<is_const, const value_type*, value_type*>;
+      using reference =
+          std::conditional_t<is_const, const value_type&, value_type&>;
+      using ContainerPointer =
+          std::conditional_t<is_const,
+                             const ProductionItemAndForwardNodesContainer*,
+                             ProductionItemAndForwardNodesContainer*>;
+
+      IteratorBase() = default;
+      IteratorBase(ContainerPointer container, size_t item_index)
+          : container_(container), item_index_(item_index) {}
+      /// @brief 允许iterator隐式转换为const_iterator
+      template <bool other_is_const>
+        requires(is_const && !other_is_const)
+      IteratorBase(const IteratorBase<other_is_const>& iterator)
+          : container_(iterator.container_),
+            item_index_(iterator.item_index_) {}
+
+      reference operator*() const {
+        assert(item_index_ < container_->items_.size());
+        return container_->items_[item_index_];
+      }
+      pointer operator->() const { return &operator*(); }
+      IteratorBase& operator++() {
+        ++item_index_;
+        return *this;
+      }
+      IteratorBase operator++(int) {
+        IteratorBase temp = *this;
+        ++item_index_;
+        return temp;
+      }
+      bool operator==(const IteratorBase& iterator) const {
+        return container_ == iterator.container_ &&
+               item_index_ == iterator.item_index_;
+      }
+      bool operator!=(const IteratorBase& iterator) const {
+        return !operator==(iterator);
+      }
+
+     private:
+      template <bool other_is_const>
+      friend class IteratorBase;
+
+      /// @brief 迭代器所属的容器
+      ContainerPointer container_ = nullptr;
+      /// @brief 指向的项在容器存储数组中的下标
+      size_t item_index_ = 0;
+    };
+    using iterator = IteratorBase<false>;
+    using const_iterator = IteratorBase<true>;
+
+    iterator begin() { return iterator(this, 0); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator cbegin() const { return begin(); }
+    iterator end() { return iterator(this, items_.size()); }
+    const_iterator end() const { return const_iterator(this, items_.size()); }
+    const_iterator cend() const { return end(); }
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+
+    /// @brief 查找项
+    /// @param[in] item ：待查找的项
+    /// @return 返回指向该项的迭代器，不存在则返回end()
+    iterator find(const ProductionItem& item) {
+      size_t item_index = FindItemIndex(PackProductionItem(item));
+      return item_index == kInvalidItemIndex ? end()
+                                             : iterator(this, item_index);
+    }
+    const_iterator find(const ProductionItem& item) const {
+      size_t item_index = FindItemIndex(PackProductionItem(item));
+      return item_index == kInvalidItemIndex
+                 ? end()
+                 : const_iterator(this, item_index);
+    }
+    /// @brief 获取项的向前看符号
+    /// @param[in] item ：项
+    /// @return 返回该项的向前看符号的引用
+    /// @note 给定项必须存在
+    ForwardNodesContainer& at(const ProductionItem& item) {
+      size_t item_index = FindItemIndex(PackProductionItem(item));
+      assert(item_index != kInvalidItemIndex);
+      return items_[item_index].second;
+    }
+    const ForwardNodesContainer& at(const ProductionItem& item) const {
+      size_t item_index = FindItemIndex(PackProductionItem(item));
+      assert(item_index != kInvalidItemIndex);
+      return items_[item_index].second;
+    }
+    /// @brief 插入项和向前看符号
+    /// @param[in] item ：待插入的项
+    /// @param[in] args ：构造向前看符号容器的参数
+    /// @return 返回指向给定项的迭代器和是否插入了新项
+    /// @note 项已存在时不修改该项的向前看符号
+    template <class... Args>
+    std::pair<iterator, bool> emplace(const ProductionItem& item,
+                                      Args&&... args);
+    std::pair<iterator, bool> insert(const value_type& value) {
+      return emplace(value.first, value.second);
+    }
+    /// @brief 交换两个容器的内容
+    void swap(ProductionItemAndForwardNodesContainer& container) {
+      items_.swap(container.items_);
+      slots_.swap(container.slots_);
+    }
+    /// @brief 清空容器
+    void clear() {
+      items_.clear();
+      slots_.clear();
+    }
+
+   private:
+    /// @brief 无效的项下标，用于标记空槽位和查找失败
+    static constexpr size_t kInvalidItemIndex =
+        std::numeric_limits<size_t>::max();
+    /// @brief 哈希表首次分配时的槽位数，必须是2的幂
+    static constexpr size_t kInitSlotNum = 16;
+
+    /// @brief 哈希表中的槽位
+    struct Slot {
+      /// @brief 压缩后的项
+      PackedProductionItem packed_item = 0;
+      /// @brief 项在存储数组中的下标，kInvalidItemIndex代表空槽位
+      size_t item_index = kInvalidItemIndex;
+    };
+    /// @brief 查找项在存储数组中的下标
+    /// @param[in] packed_item ：压缩后的项
+    /// @return 返回项在存储数组中的下标，不存在则返回kInvalidItemIndex
+    size_t FindItemIndex(PackedProductionItem packed_item) const {
+      if (slots_.empty()) [[unlikely]] {
+        return kInvalidItemIndex;
+      }
+      return slots_[FindSlotIndex(packed_item)].item_index;
+    }
+    /// @brief 查找项所在的槽位
+    /// @param[in] packed_item ：压缩后的项
+    /// @return 返回项所在的槽位下标，项不存在则返回探测到的第一个空槽位下标
+    /// @attention 哈希表中必须至少存在一个空槽位
+    size_t FindSlotIndex(PackedProductionItem packed_item) const;
+    /// @brief 重建哈希表
+    /// @param[in] slot_num ：新的槽位数，必须是2的幂
+    void Rehash(size_t slot_num);
+
+    /// @brief 按插入顺序存储的项和向前看符号
+    std::vector<value_type> items_;
+    /// @brief 开放定址哈希表的槽位，负载因子不超过1/2
+    std::vector<Slot> slots_;
+  };
 
   ProductionItemSet() {}
   ProductionItemSet(SyntaxAnalysisTableEntryId syntax_analysis_table_entry_id)
@@ -53,7 +370,9 @@ class ProductionItemSet {
         syntax_analysis_table_entry_id_(
             std::move(production_item_set.syntax_analysis_table_entry_id_)),
         item_and_forward_node_ids_(
-            std::move(production_item_set.item_and_forward_node_ids_)) {}
+            std::move(production_item_set.item_and_forward_node_ids_)),
+        pending_forward_node_ids_(
+            std::move(production_item_set.pending_forward_node_ids_)) {}
   ProductionItemSet& operator=(ProductionItemSet&& production_item_set);
 
   /// @brief 向项集中插入项和对应的向前看符号
@@ -62,7 +381,6 @@ class ProductionItemSet {
   /// @return 返回指向给定Item的iterator和是否插入了新项
   /// @note
   /// 如果Item已存在则仅添加向前看符号且第二个返回参数为false
-  /// 可以使用单个未包装ID
   /// @attention 插入时该项集必须没求过闭包，因为求过闭包的项集可能在之后的构建
   /// 过程中被再次引用
   /// forward_node_ids必须不为空，所有项都一定有向前看符号
@@ -70,13 +388,22 @@ class ProductionItemSet {
   std::pair<ProductionItemAndForwardNodesContainer::iterator, bool>
   AddItemAndForwardNodeIds(const ProductionItem& item,
                            ForwardNodeIdContainer&& forward_node_ids);
+  /// @brief 向项集中的项传播向前看符号，项不存在时插入该项
+  /// @param[in] item ：接收向前看符号的项
+  /// @param[in] forward_node_ids ：待传播的向前看符号
+  /// @return 返回该项新增的向前看符号，插入新项时为forward_node_ids的全部内容
+  /// @note
+  /// 1.用于求闭包时在项集内部传播向前看符号，返回值为空时无需继续传播
+  /// 2.不会设置闭包无效
+  /// @attention 已经求过闭包的项集内所有的项都已存在，不允许插入新项
+  ForwardNodesContainer SpreadForwardNodesToItem(
+      const ProductionItem& item, const ForwardNodesContainer& forward_node_ids);
   /// @brief 向项集中插入核心项和对应的向前看符号
   /// @param[in] item ：待插入的项
   /// @param[in] forward_node_ids ：待插入的项的向前看符号
   /// @return 返回指向给定Item的iterator和是否插入了新项
   /// @note
   /// 如果Item已存在则仅添加向前看符号且第二个返回参数为false
-  /// 可以使用单个未包装ID
   /// 在求闭包时从核心项开始展开
   /// @attention 插入时该项集必须没求过闭包，因为求过闭包的项集可能在之后的构建
   /// 过程中被再次引用
@@ -90,6 +417,34 @@ class ProductionItemSet {
     SetMainItem(result.first);
     return result;
   }
+  /// @brief 向项集中插入不携带向前看符号的项
+  /// @param[in] item ：待插入的项
+  /// @param[in] empty_forward_node_ids ：空的向前看符号位集
+  /// @return 返回指向给定Item的iterator和是否插入了新项
+  /// @note 仅用于LALR(1)模式下构建LR(0)项集族，向前看符号在项集族构建完成后
+  /// 统一计算
+  /// @attention 插入时该项集必须没求过闭包
+  std::pair<ProductionItemAndForwardNodesContainer::iterator, bool> AddLr0Item(
+      const ProductionItem& item,
+      ForwardNodesContainer&& empty_forward_node_ids) {
+    assert(!IsClosureAvailable());
+    assert(empty_forward_node_ids.Empty());
+    return item_and_forward_node_ids_.emplace(
+        item, std::move(empty_forward_node_ids));
+  }
+  /// @brief 向项集中插入不携带向前看符号的核心项
+  /// @param[in] item ：待插入的核心项
+  /// @param[in] empty_forward_node_ids ：空的向前看符号位集
+  /// @return 返回指向给定Item的iterator和是否插入了新项
+  /// @note 仅用于LALR(1)模式下构建LR(0)项集族
+  /// @attention 插入时该项集必须没求过闭包
+  std::pair<ProductionItemAndForwardNodesContainer::iterator, bool>
+  AddLr0MainItem(const ProductionItem& item,
+                 ForwardNodesContainer&& empty_forward_node_ids) {
+    auto result = AddLr0Item(item, std::move(empty_forward_node_ids));
+    SetMainItem(result.first);
+    return result;
+  }
 
   /// @brief 判断给定项是否在该项集内
   /// @return 返回给定项是否在该项集内
@@ -103,6 +458,9 @@ class ProductionItemSet {
   /// @return 返回该项集求的闭包是否有效
   /// @retval true ：该项集闭包有效，无需重求
   /// @retval false ：该项集闭包无效，需要求闭包才能使用
+  /// @note
+  /// 闭包中的项仅由核心项决定，核心项新增的向前看符号记录为待传播的向前看符号，
+  /// 不会使闭包无效
   bool IsClosureAvailable() const {
     return production_item_set_closure_available_;
   }
@@ -150,13 +508,29 @@ class ProductionItemSet {
   /// @retval true ：添加了向前看符号
   /// @retval false ：forward_node_id_container中全部向前看符号均已存在
   /// @note
-  /// 1.forward_node_id_container支持输入单个向前看符号和存储向前看符号的容器
+  /// 1.forward_node_id_container为存储向前看符号的位集
   /// 2.item必须为核心项，否则请调用AddItemAndForwardNodeIds及类似函数
-  /// 3.如果添加了新的向前看符号则设置闭包无效
+  /// 3.新增的向前看符号记录为该核心项待传播的向前看符号，不会设置闭包无效
   /// @attention item必须已经添加到该项集中
   template <class ForwardNodeIdContainer>
   bool AddForwardNodes(const ProductionItem& item,
                        ForwardNodeIdContainer&& forward_node_id_container);
+  /// @brief 判断是否存在待传播的向前看符号
+  /// @return 返回是否存在核心项新增且尚未在闭包中传播的向前看符号
+  bool HasPendingForwardNodes() const {
+    return !pending_forward_node_ids_.empty();
+  }
+  /// @brief 取出全部待传播的向前看符号
+  /// @return 返回核心项和该核心项待传播的向前看符号
+  /// @note 调用后该项集不存在待传播的向前看符号
+  ProductionItemAndForwardNodesContainer TakePendingForwardNodes() {
+    ProductionItemAndForwardNodesContainer pending_forward_node_ids;
+    pending_forward_node_ids.swap(pending_forward_node_ids_);
+    return pending_forward_node_ids;
+  }
+  /// @brief 清空待传播的向前看符号
+  /// @note 求闭包时从核心项的全部向前看符号开始传播，无需保留增量
+  void ClearPendingForwardNodes() { pending_forward_node_ids_.clear(); }
   /// @brief 清空所有非核心项
   void ClearNotMainItem();
   /// @brief 判断给定项是否为该项集的核心项
@@ -179,21 +553,23 @@ class ProductionItemSet {
   /// 要求指定的项未被设置成核心项过
   /// 自动设置闭包无效
   void SetMainItem(
-      ProductionItemAndForwardNodesContainer ::const_iterator& item_iter);
+      ProductionItemAndForwardNodesContainer::const_iterator item_iter);
   /// @brief 向给定项中添加向前看符号
   /// @param[in] iter ：待添加向前看符号的项
   /// @param[in] forward_node_id_container ：待添加的向前看符号
+  /// @param[out] added_forward_node_ids ：存储新增的向前看符号
   /// @return 返回是否添加了新的向前看符号
   /// @retval true ：添加了向前看符号
   /// @retval false ：forward_node_id_container中全部向前看符号均已存在
   /// @note
   /// 1.向已有的项集中添加向前看符号最终都应走该接口
-  /// 2.forward_node_id_container支持输入单个向前看符号和存储向前看符号的容器
-  /// 3.如果添加了新的向前看符号则设置闭包无效
+  /// 2.forward_node_id_container为存储向前看符号的位集，按字合并
+  /// 3.added_forward_node_ids可以为nullptr
   template <class ForwardNodeIdContainer>
   bool AddForwardNodes(
       const ProductionItemAndForwardNodesContainer::iterator& iter,
-      ForwardNodeIdContainer&& forward_node_id_container);
+      ForwardNodeIdContainer&& forward_node_id_container,
+      ForwardNodesContainer* added_forward_node_ids = nullptr);
   /// @brief 设置闭包无效
   /// @note 每个修改了项/项的向前看符号的函数都应设置闭包无效
   void SetClosureNotAvailable() {
@@ -218,8 +594,31 @@ class ProductionItemSet {
       SyntaxAnalysisTableEntryId::InvalidId();
   /// @brief 项和对应的向前看符号
   ProductionItemAndForwardNodesContainer item_and_forward_node_ids_;
+  /// @brief 核心项和该核心项新增且尚未在闭包中传播的向前看符号
+  ProductionItemAndForwardNodesContainer pending_forward_node_ids_;
 };
 
+template <class... Args>
+std::pair<ProductionItemSet::ProductionItemAndForwardNodesContainer::iterator,
+          bool>
+ProductionItemSet::ProductionItemAndForwardNodesContainer::emplace(
+    const ProductionItem& item, Args&&... args) {
+  // 保证插入后负载因子不超过1/2，同时哈希表中一定存在空槽位
+  if ((items_.size() + 1) * 2 > slots_.size()) [[unlikely]] {
+    Rehash(slots_.empty() ? kInitSlotNum : slots_.size() * 2);
+  }
+  PackedProductionItem packed_item = PackProductionItem(item);
+  Slot& slot = slots_[FindSlotIndex(packed_item)];
+  if (slot.item_index != kInvalidItemIndex) {
+    return std::make_pair(iterator(this, slot.item_index), false);
+  }
+  slot.packed_item = packed_item;
+  slot.item_index = items_.size();
+  items_.emplace_back(std::piecewise_construct, std::forward_as_tuple(item),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+  return std::make_pair(iterator(this, slot.item_index), true);
+}
+
 template <class ForwardNodeIdContainer>
 std::pair<ProductionItemSet::ProductionItemAndForwardNodesContainer::iterator,
           bool>
@@ -228,11 +627,11 @@ ProductionItemSet::AddItemAndForwardNodeIds(
   // 已经求过闭包的项集不能添加新项
   assert(!IsClosureAvailable());
   // 任何项都必须携带向前看符号
-  assert(forward_node_ids.size() != 0);
+  assert(!forward_node_ids.Empty());
   auto iter = item_and_forward_node_ids_.find(item);
   if (iter == item_and_forward_node_ids_.end()) {
     return item_and_forward_node_ids_.emplace(
-        item, std::unordered_set<ProductionNodeId>(
+        item, ForwardNodesContainer(
                   std::forward<ForwardNodeIdContainer>(forward_node_ids)));
   } else {
     AddForwardNodes(iter,
@@ -258,35 +657,30 @@ inline bool ProductionItemSet::AddForwardNodes(
 #endif  // _DEBUG
   auto iter = item_and_forward_node_ids_.find(item);
   assert(iter != item_and_forward_node_ids_.end());
-  return AddForwardNodes(
-      iter, std::forward<ForwardNodeIdContainer>(forward_node_id_container));
+  ForwardNodesContainer added_forward_node_ids =
+      forward_node_id_container.CreateEmptyWithSameSize();
+  if (!AddForwardNodes(iter, forward_node_id_container,
+                       &added_forward_node_ids)) {
+    return false;
+  }
+  // 记录新增的向前看符号，等待在该项集的闭包中传播
+  auto pending_iter = pending_forward_node_ids_.find(item);
+  if (pending_iter == pending_forward_node_ids_.end()) {
+    pending_forward_node_ids_.emplace(item, std::move(added_forward_node_ids));
+  } else {
+    pending_iter->second.UnionWith(added_forward_node_ids);
+  }
+  return true;
 }
 
 template <class ForwardNodeIdContainer>
 inline bool ProductionItemSet::AddForwardNodes(
     const ProductionItemAndForwardNodesContainer::iterator& iter,
-    ForwardNodeIdContainer&& forward_node_id_container) {
+    ForwardNodeIdContainer&& forward_node_id_container,
+    ForwardNodesContainer* added_forward_node_ids) {
   assert(iter != item_and_forward_node_ids_.end());
-  bool result;
-  if constexpr (std::is_same_v<std::decay_t<ForwardNodeIdContainer>,
-                               ProductionNodeId>) {
-    // 对单个向前看符号特化
-    result = iter->second
-                 .emplace(std::forward<ForwardNodeIdContainer>(
-                     forward_node_id_container))
-                 .second;
-  } else {
-    // 对容器特化
-    result = false;
-    for (auto& forward_node_id : forward_node_id_container) {
-      result |= iter->second.insert(forward_node_id).second;
-    }
-  }
-  // 如果添加了新的向前看节点则设置闭包无效
-  if (result) {
-    SetClosureNotAvailable();
-  }
-  return result;
+  return iter->second.UnionWith(forward_node_id_container,
+                                added_forward_node_ids);
 }
 
 }  // namespace frontend::generator::syntax_generator
@@ -1,5 +1,6 @@
 ﻿#include "syntax_generator.h"
 
+#include <algorithm>
 #include <codecvt>
 #include <queue>
 
@@ -468,80 +469,124 @@ SyntaxGenerator::GetProductionItemSetIdFromProductionItem(
       body_id, next_word_to_shift_index);
 }
 
-void SyntaxGenerator::GetNonTerminalNodeFirstNodeIds(
-    ProductionNodeId production_node_id, ForwardNodesContainer* result,
-    std::unordered_set<ProductionNodeId>&& processed_nodes) {
-  bool inserted = processed_nodes.insert(production_node_id).second;
-  assert(inserted);
-  assert(production_node_id.IsValid());
-  assert(result);
-  NonTerminalProductionNode& production_node =
-      static_cast<NonTerminalProductionNode&>(
-          GetProductionNode(production_node_id));
-  assert(production_node.GetType() == ProductionNodeType::kNonTerminalNode);
-  for (auto& body : production_node.GetAllBody()) {
-    NextWordToShiftIndex node_id_index(0);
-    // 正在处理的产生式节点的ID
-    ProductionNodeId node_id;
-    while (node_id_index < body.production_body.size()) {
-      node_id = body.production_body[node_id_index];
-      if (GetProductionNode(node_id).GetType() !=
-          ProductionNodeType::kNonTerminalNode) {
-        result->insert(node_id);
-        break;
-      }
-      assert(node_id.IsValid());
-      // 检查该节点是否已经处理过
-      if (processed_nodes.find(node_id) == processed_nodes.end()) {
-        // 如果该节点未处理则获取该节点的first节点ID并添加到主first节点ID集合中
-        GetNonTerminalNodeFirstNodeIds(node_id, result,
-                                       std::move(processed_nodes));
+void SyntaxGenerator::ForwardNodeIndexConstruct() {
+  production_node_id_to_forward_node_index_.clear();
+  forward_node_index_to_production_node_id_.clear();
+  ObjectManager<BaseProductionNode>::ConstIterator iter =
+      manager_nodes_.ConstBegin();
+  while (iter != manager_nodes_.ConstEnd()) {
+    if (iter->GetType() != ProductionNodeType::kNonTerminalNode) {
+      ProductionNodeId node_id = iter->GetNodeId();
+      if (node_id >= production_node_id_to_forward_node_index_.size()) {
+        production_node_id_to_forward_node_index_.resize(
+            node_id + 1, std::numeric_limits<size_t>::max());
       }
-      if (static_cast<NonTerminalProductionNode&>(GetProductionNode(node_id))
-              .CouldBeEmptyReduct()) {
-        // 该非终结节点可以空规约，需要考虑后面的节点
-        ++node_id_index;
-      } else {
-        // 已处理所有节点，跳出循环
-        break;
+      production_node_id_to_forward_node_index_[node_id] =
+          forward_node_index_to_production_node_id_.size();
+      forward_node_index_to_production_node_id_.push_back(node_id);
+    }
+    ++iter;
+  }
+}
+
+void SyntaxGenerator::NullableAndFirstSetConstruct() {
+  const size_t production_node_num =
+      production_node_id_to_forward_node_index_.size();
+  nonterminal_node_first_sets_.assign(production_node_num,
+                                      CreateForwardNodesContainer());
+  nonterminal_node_nullable_.assign(production_node_num, false);
+  // 所有非终结节点ID
+  std::vector<ProductionNodeId> nonterminal_node_ids;
+  ObjectManager<BaseProductionNode>::ConstIterator iter =
+      manager_nodes_.ConstBegin();
+  while (iter != manager_nodes_.ConstEnd()) {
+    if (iter->GetType() == ProductionNodeType::kNonTerminalNode) {
+      ProductionNodeId node_id = iter->GetNodeId();
+      if (node_id >= nonterminal_node_first_sets_.size()) {
+        nonterminal_node_first_sets_.resize(node_id + 1,
+                                            CreateForwardNodesContainer());
+        nonterminal_node_nullable_.resize(node_id + 1, false);
       }
+      // 用户设置的可以空规约的节点一定可空
+      nonterminal_node_nullable_[node_id] =
+          static_cast<const NonTerminalProductionNode&>(*iter)
+              .CouldBeEmptyReduct();
+      nonterminal_node_ids.push_back(node_id);
     }
+    ++iter;
   }
+  bool changed;
+  do {
+    changed = false;
+    for (ProductionNodeId nonterminal_node_id : nonterminal_node_ids) {
+      ForwardNodesContainer& first_set =
+          nonterminal_node_first_sets_[nonterminal_node_id];
+      for (const auto& body :
+           static_cast<const NonTerminalProductionNode&>(
+               GetProductionNode(nonterminal_node_id))
+               .GetAllBody()) {
+        // 产生式体的所有节点是否均可空
+        bool body_nullable = true;
+        for (ProductionNodeId node_id : body.production_body) {
+          if (GetProductionNode(node_id).GetType() !=
+              ProductionNodeType::kNonTerminalNode) {
+            changed |= first_set.Set(GetForwardNodeIndex(node_id));
+            body_nullable = false;
+            break;
+          }
+          // 产生式头可能出现在自己的产生式体中，此时无需合并
+          if (node_id != nonterminal_node_id) {
+            changed |= first_set.UnionWith(
+                nonterminal_node_first_sets_[node_id]);
+          }
+          if (!nonterminal_node_nullable_[node_id]) {
+            body_nullable = false;
+            break;
+          }
+        }
+        if (body_nullable && !nonterminal_node_nullable_[nonterminal_node_id]) {
+          nonterminal_node_nullable_[nonterminal_node_id] = true;
+          changed = true;
+        }
+      }
+    }
+  } while (changed);
 }
 
 SyntaxGenerator::ForwardNodesContainer SyntaxGenerator::First(
     ProductionNodeId production_node_id, ProductionBodyId production_body_id,
     NextWordToShiftIndex next_word_to_shift_index,
-    const ForwardNodesContainer& next_node_ids) {
-  ProductionNodeId node_id = GetProductionNodeIdInBody(
-      production_node_id, production_body_id, next_word_to_shift_index);
-  if (node_id.IsValid()) {
-    ForwardNodesContainer forward_nodes;
+    const ForwardNodesContainer& next_node_ids) const {
+  const auto& production_body =
+      static_cast<const NonTerminalProductionNode&>(
+          GetProductionNode(production_node_id))
+          .GetBody(production_body_id)
+          .production_body;
+  ForwardNodesContainer forward_nodes = CreateForwardNodesContainer();
+  for (size_t index = next_word_to_shift_index; index < production_body.size();
+       index++) {
+    ProductionNodeId node_id = production_body[index];
     switch (GetProductionNode(node_id).GetType()) {
       case ProductionNodeType::kTerminalNode:
       case ProductionNodeType::kOperatorNode:
-        forward_nodes.insert(node_id);
-        break;
+        forward_nodes.Set(GetForwardNodeIndex(node_id));
+        return forward_nodes;
       case ProductionNodeType::kNonTerminalNode:
         // 合并当前·右侧非终结节点可能的所有单词ID
-        GetNonTerminalNodeFirstNodeIds(node_id, &forward_nodes);
-        if (static_cast<NonTerminalProductionNode&>(GetProductionNode(node_id))
-                .CouldBeEmptyReduct()) {
-          // 当前·右侧的非终结节点可以空规约，需要考虑它下一个节点的情况
-          forward_nodes.merge(
-              First(production_node_id, production_body_id,
-                    NextWordToShiftIndex(next_word_to_shift_index + 1),
-                    next_node_ids));
+        forward_nodes.UnionWith(GetNonTerminalNodeFirstSet(node_id));
+        if (!IsNonTerminalNodeNullable(node_id)) {
+          return forward_nodes;
         }
+        // 当前·右侧的非终结节点可以空规约，需要考虑它下一个节点的情况
         break;
       default:
         assert(false);
         break;
     }
-    return forward_nodes;
-  } else {
-    return next_node_ids;
   }
+  // β可以推导出空串，合并待展开的非终结产生式所在项的向前看符号
+  forward_nodes.UnionWith(next_node_ids);
+  return forward_nodes;
 }
 
 bool SyntaxGenerator::ProductionItemSetClosure(
@@ -565,21 +610,44 @@ bool SyntaxGenerator::ProductionItemSetClosure(
   syntax_analysis_table_entry.Clear();
   // 清空非核心项
   production_item_set.ClearNotMainItem();
-  // 存储当前待展开的项
-  // 存储指向待展开项的迭代器
-  std::queue<ProductionItemAndForwardNodesContainer::const_iterator>
-      items_waiting_process;
-  const auto& production_items_and_forward_nodes =
-      GetProductionItemsAndForwardNodes(production_item_set_id);
+  // 从核心项的全部向前看符号开始传播，无需保留待传播的增量
+  production_item_set.ClearPendingForwardNodes();
+  // 存储待展开的项和该项需要传播的向前看符号
+  std::queue<std::pair<ProductionItem, ForwardNodesContainer>>
+      items_waiting_spread;
   for (auto& iter : GetProductionItemSetMainItems(production_item_set_id)) {
     // 将项集中所有核心项压入待处理队列
-    items_waiting_process.push(iter);
+    items_waiting_spread.emplace(iter->first, iter->second);
   }
-  while (!items_waiting_process.empty()) {
-    auto item_now = items_waiting_process.front();
-    items_waiting_process.pop();
+  // 项集转移表尚未建立，仅在项集内部传播
+  SpreadForwardNodesInProductionItemSet(
+      production_item_set_id, std::move(items_waiting_spread), nullptr);
+  SetProductionItemSetClosureAvailable(production_item_set_id);
+  LOG_INFO("SyntaxGenerator",
+           std::format("完成对ProductionItemID = {:}的项集的闭包操作",
+                       production_item_set_id.GetRawValue()));
+  LOG_INFO("SyntaxGenerator",
+           std::format("该项集具有的项和向前看符号如下：\n") +
+               FormatProductionItems(production_item_set_id));
+  return true;
+}
+
+void SyntaxGenerator::SpreadForwardNodesInProductionItemSet(
+    ProductionItemSetId production_item_set_id,
+    std::queue<std::pair<ProductionItem, ForwardNodesContainer>>&&
+        items_waiting_spread,
+    std::list<ProductionItemSetId>* production_item_set_changed_ids) {
+  ProductionItemSet& production_item_set =
+      GetProductionItemSet(production_item_set_id);
+  SyntaxAnalysisTableEntry& syntax_analysis_table_entry =
+      GetSyntaxAnalysisTableEntry(
+          production_item_set.GetSyntaxAnalysisTableEntryId());
+  while (!items_waiting_spread.empty()) {
+    auto [item_now, forward_node_ids_now] =
+        std::move(items_waiting_spread.front());
+    items_waiting_spread.pop();
     const auto [production_node_id, production_body_id,
-                next_word_to_shift_index] = item_now->first;
+                next_word_to_shift_index] = item_now;
     NonTerminalProductionNode& production_node_now =
         static_cast<NonTerminalProductionNode&>(
             GetProductionNode(production_node_id));
@@ -596,35 +664,50 @@ bool SyntaxGenerator::ProductionItemSetClosure(
           GetProcessFunctionClass(production_node_id, production_body_id),
           GetProductionBody(production_node_id, production_body_id));
       LOG_INFO("SyntaxGenerator",
-               std::format("项：") + FormatProductionItem(item_now->first));
+               std::format("项：") + FormatProductionItem(item_now));
       LOG_INFO("SyntaxGenerator",
                std::format("在向前看符号：") +
-                   FormatLookForwardSymbols(item_now->second) + " 下执行规约");
-      const auto& production_body =
-          production_node_now.GetBody(production_body_id).production_body;
-      for (auto node_id : item_now->second) {
+                   FormatLookForwardSymbols(forward_node_ids_now) +
+                   " 下执行规约");
+      forward_node_ids_now.ForEach([&](size_t forward_node_index) {
         // 对每个向前看符号设置规约操作
         syntax_analysis_table_entry.SetTerminalNodeActionAndAttachedData(
-            node_id, reduct_attached_data);
-      }
+            GetForwardNodeIdFromIndex(forward_node_index),
+            reduct_attached_data);
+      });
       continue;
     }
-    NonTerminalProductionNode& next_production_node =
-        static_cast<NonTerminalProductionNode&>(
-            GetProductionNode(next_production_node_id));
-    if (next_production_node.GetType() !=
+    if (production_item_set_changed_ids != nullptr) {
+      // 项集转移表已建立，向移入下一个节点后到达的项集传播向前看符号
+      ProductionItemSetId production_item_set_after_transform_id =
+          GetProductionItemSetIdAfterTransform(production_item_set_id,
+                                               next_production_node_id);
+      if (AddForwardNodes(production_item_set_after_transform_id,
+                          ProductionItem(production_node_id, production_body_id,
+                                         NextWordToShiftIndex(
+                                             next_word_to_shift_index + 1)),
+                          forward_node_ids_now)) {
+        production_item_set_changed_ids->push_back(
+            production_item_set_after_transform_id);
+      }
+    }
+    if (GetProductionNode(next_production_node_id).GetType() !=
         ProductionNodeType::kNonTerminalNode) {
       LOG_INFO("SyntaxGenerator",
-               std::format("项：") + FormatProductionItem(item_now->first) +
+               std::format("项：") + FormatProductionItem(item_now) +
                    std::format(" 由于下一个移入的符号为终结节点而终止展开"));
       continue;
     }
+    NonTerminalProductionNode& next_production_node =
+        static_cast<NonTerminalProductionNode&>(
+            GetProductionNode(next_production_node_id));
     // 展开非终结节点，并为其创建向前看符号集
     ForwardNodesContainer&& forward_node_ids = First(
         production_node_id, production_body_id,
-        NextWordToShiftIndex(next_word_to_shift_index + 1), item_now->second);
+        NextWordToShiftIndex(next_word_to_shift_index + 1),
+        forward_node_ids_now);
     LOG_INFO("SyntaxGenerator",
-             std::format("项：") + FormatProductionItem(item_now->first) +
+             std::format("项：") + FormatProductionItem(item_now) +
                  std::format(" 正在展开非终结节点 {:}",
                              GetNextNodeToShiftSymbolString(
                                  production_node_id, production_body_id,
@@ -634,55 +717,48 @@ bool SyntaxGenerator::ProductionItemSetClosure(
                  FormatLookForwardSymbols(forward_node_ids));
     for (auto body_id : next_production_node.GetAllBodyIds()) {
       // 将该非终结节点中的每个产生式体加入到production_item_set中，点在最左侧
-      auto [iter, inserted] = AddItemAndForwardNodeIdsToProductionItem(
-          production_item_set_id,
-          ProductionItem(next_production_node_id, body_id,
-                         NextWordToShiftIndex(0)),
-          forward_node_ids);
-      if (inserted) {
-        // 如果插入新的项则添加到队列中等待处理，并记录该项属于的新项集ID
-        items_waiting_process.push(iter);
+      ProductionItem new_item(next_production_node_id, body_id,
+                              NextWordToShiftIndex(0));
+      ForwardNodesContainer&& added_forward_node_ids =
+          production_item_set.SpreadForwardNodesToItem(new_item,
+                                                       forward_node_ids);
+      if (!added_forward_node_ids.Empty()) {
+        // 如果插入新的项或项获得新的向前看符号则继续传播新增的部分
         LOG_INFO("SyntaxGenerator",
-                 std::format("向项集中插入新项：") +
-                     FormatProductionItem(iter->first) +
-                     std::format(" 向前看符号：") +
-                     FormatLookForwardSymbols(forward_node_ids));
+                 std::format("向项：") + FormatProductionItem(new_item) +
+                     std::format(" 添加向前看符号：") +
+                     FormatLookForwardSymbols(added_forward_node_ids));
+        items_waiting_spread.emplace(std::move(new_item),
+                                     std::move(added_forward_node_ids));
       }
     }
     if (next_production_node.CouldBeEmptyReduct()) {
       // ·右侧的非终结节点可以空规约
       // 向项集中添加空规约后得到的项，向前看符号复制原来的项的向前看符号集
-      auto [iter, inserted] = AddItemAndForwardNodeIdsToProductionItem(
-          production_item_set_id,
-          ProductionItem(production_node_id, production_body_id,
-                         NextWordToShiftIndex(next_word_to_shift_index + 1)),
-          item_now->second);
-      if (inserted) {
-        // 如果插入新的项则添加到队列中等待处理
-        items_waiting_process.push(iter);
+      ProductionItem new_item(
+          production_node_id, production_body_id,
+          NextWordToShiftIndex(next_word_to_shift_index + 1));
+      ForwardNodesContainer&& added_forward_node_ids =
+          production_item_set.SpreadForwardNodesToItem(new_item,
+                                                       forward_node_ids_now);
+      if (!added_forward_node_ids.Empty()) {
         LOG_INFO(
             "SyntaxGenerator",
-            std::format("由于非终结产生式 {:} 可以空规约，向项集中插入新项：",
+            std::format("由于非终结产生式 {:} 可以空规约，向项集中添加项：",
                         GetNextNodeToShiftSymbolString(
                             production_node_id, production_body_id,
                             next_word_to_shift_index)) +
-                FormatProductionItemAndLookForwardSymbols(iter->first,
-                                                          item_now->second));
+                FormatProductionItemAndLookForwardSymbols(
+                    new_item, added_forward_node_ids));
+        items_waiting_spread.emplace(std::move(new_item),
+                                     std::move(added_forward_node_ids));
       }
     }
     LOG_INFO("SyntaxGenerator", std::format("项：") +
                                     FormatProductionItemAndLookForwardSymbols(
-                                        item_now->first, item_now->second) +
+                                        item_now, forward_node_ids_now) +
                                     std::format(" 已展开"));
   }
-  SetProductionItemSetClosureAvailable(production_item_set_id);
-  LOG_INFO("SyntaxGenerator",
-           std::format("完成对ProductionItemID = {:}的项集的闭包操作",
-                       production_item_set_id.GetRawValue()));
-  LOG_INFO("SyntaxGenerator",
-           std::format("该项集具有的项和向前看符号如下：\n") +
-               FormatProductionItems(production_item_set_id));
-  return true;
 }
 
 ProductionItemSetId SyntaxGenerator::GetProductionItemSetIdFromProductionItems(
@@ -755,25 +831,77 @@ ProductionItemSetId SyntaxGenerator::GetProductionItemSetIdFromProductionItems(
   return ProductionItemSetId::InvalidId();
 }
 
-bool SyntaxGenerator::
+void SyntaxGenerator::
     SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
-        ProductionItemSetId production_item_set_id) {
-  // 如果未执行闭包操作则无需执行传播步骤
-  if (!ProductionItemSetClosure(production_item_set_id)) [[unlikely]] {
+        ProductionItemSetId root_production_item_set_id) {
+  // 等待处理的项集ID，同一个项集在队列中最多出现一次
+  std::queue<ProductionItemSetId> production_item_set_waiting_spread_ids;
+  // 已在队列中的项集ID
+  std::unordered_set<ProductionItemSetId> production_item_set_in_queue_ids;
+  production_item_set_waiting_spread_ids.push(root_production_item_set_id);
+  production_item_set_in_queue_ids.insert(root_production_item_set_id);
+  while (!production_item_set_waiting_spread_ids.empty()) {
+    ProductionItemSetId production_item_set_id =
+        production_item_set_waiting_spread_ids.front();
+    production_item_set_waiting_spread_ids.pop();
+    production_item_set_in_queue_ids.erase(production_item_set_id);
+    // 核心项获得新向前看符号的项集ID，里面的ID可能重复
+    std::list<ProductionItemSetId> production_item_set_changed_ids;
+    if (ProductionItemSetClosure(production_item_set_id)) {
+      // 新项集，求闭包后建立转移表
+      ProductionItemSetTransformConstruct(production_item_set_id,
+                                          &production_item_set_changed_ids);
+    } else {
+      // 已建立转移表的项集，仅传播核心项新增的向前看符号
+      SpreadPendingForwardNodes(production_item_set_id,
+                                &production_item_set_changed_ids);
+    }
+    for (auto production_item_set_changed_id :
+         production_item_set_changed_ids) {
+      if (production_item_set_in_queue_ids.insert(production_item_set_changed_id)
+              .second) {
+        production_item_set_waiting_spread_ids.push(
+            production_item_set_changed_id);
+      }
+    }
+  }
+}
+
+void SyntaxGenerator::SpreadPendingForwardNodes(
+    ProductionItemSetId production_item_set_id,
+    std::list<ProductionItemSetId>* production_item_set_changed_ids) {
+  ProductionItemSet& production_item_set =
+      GetProductionItemSet(production_item_set_id);
+  assert(production_item_set.IsClosureAvailable());
+  if (!production_item_set.HasPendingForwardNodes()) [[unlikely]] {
     LOG_INFO("SyntaxGenerator",
-             std::format(
-                 "ID = {:}的项集在求闭包后没有任何更改，无需重新传播向前看符号",
-                 production_item_set_id.GetRawValue()));
-    return false;
+             std::format("ID = {:}的项集没有待传播的向前看符号",
+                         production_item_set_id.GetRawValue()));
+    return;
   }
+  LOG_INFO("SyntaxGenerator",
+           std::format("对ID = {:}的项集传播新增的向前看符号",
+                       production_item_set_id.GetRawValue()));
+  std::queue<std::pair<ProductionItem, ForwardNodesContainer>>
+      items_waiting_spread;
+  for (auto& [item, added_forward_node_ids] :
+       production_item_set.TakePendingForwardNodes()) {
+    items_waiting_spread.emplace(item, std::move(added_forward_node_ids));
+  }
+  SpreadForwardNodesInProductionItemSet(production_item_set_id,
+                                        std::move(items_waiting_spread),
+                                        production_item_set_changed_ids);
+}
+
+void SyntaxGenerator::ProductionItemSetTransformConstruct(
+    ProductionItemSetId production_item_set_id,
+    std::list<ProductionItemSetId>* production_item_set_changed_ids) {
   LOG_INFO("SyntaxGenerator",
            std::format("对ID = {:}的项集传播向前看符号",
                        production_item_set_id.GetRawValue()));
   // 执行闭包操作后可以空规约达到的每一项都在production_item_set内
   // 所以处理时无需考虑某项空规约可能达到的项，因为这些项都存在于production_item_set内
 
-  // 需要传播向前看符号的production_item_set的ID，里面的ID可能重复
-  std::list<ProductionItemSetId> production_item_set_waiting_spread_ids;
   SyntaxAnalysisTableEntryId syntax_analysis_table_entry_id =
       GetProductionItemSet(production_item_set_id)
           .GetSyntaxAnalysisTableEntryId();
@@ -835,7 +963,7 @@ bool SyntaxGenerator::
       }
       // 如果向已有项集的项中添加了新的向前看符号则重新传播该项
       if (new_forward_node_inserted) {
-        production_item_set_waiting_spread_ids.push_back(
+        production_item_set_changed_ids->push_back(
             production_item_set_after_transform_id);
         LOG_INFO(
             "SyntaxGenerator",
@@ -857,12 +985,18 @@ bool SyntaxGenerator::
         ProductionItem shifted_item = item_and_forward_nodes_iter->first;
         // 获取移入符号后的项数据
         ++std::get<NextWordToShiftIndex>(shifted_item);
-        auto result = AddMainItemAndForwardNodeIdsToProductionItem(
-            production_item_set_after_transform_id, shifted_item,
-            item_and_forward_nodes_iter->second);
+        // LALR(1)模式下构建LR(0)项集族，项不携带向前看符号
+        auto result =
+            syntax_analysis_table_construct_mode_ ==
+                    SyntaxAnalysisTableConstructMode::kLalr
+                ? AddLr0MainItemToProductionItem(
+                      production_item_set_after_transform_id, shifted_item)
+                : AddMainItemAndForwardNodeIdsToProductionItem(
+                      production_item_set_after_transform_id, shifted_item,
+                      item_and_forward_nodes_iter->second);
         assert(result.second);
       }
-      production_item_set_waiting_spread_ids.push_back(
+      production_item_set_changed_ids->push_back(
           production_item_set_after_transform_id);
     }
     SyntaxAnalysisTableEntry& syntax_analysis_table_entry =
@@ -905,15 +1039,387 @@ bool SyntaxGenerator::
   LOG_INFO("SyntaxGenerator",
            std::format("ID = {:}的项集传播向前看符号操作已完成",
                        production_item_set_id.GetRawValue()));
-  for (auto production_item_set_waiting_spread_id :
-       production_item_set_waiting_spread_ids) {
-    // 对新生成的每个项集都传播向前看符号
-    SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
-        production_item_set_waiting_spread_id);
+}
+
+std::pair<SyntaxGenerator::ProductionItemAndForwardNodesContainer::iterator,
+          bool>
+SyntaxGenerator::AddLr0MainItemToProductionItem(
+    ProductionItemSetId production_item_set_id,
+    const ProductionItem& production_item) {
+  auto result = GetProductionItemSet(production_item_set_id)
+                    .AddLr0MainItem(production_item,
+                                    CreateForwardNodesContainer());
+  if (result.second) {
+    // 向项集中插入了新的项则更新该项属于的项集
+    AddProductionItemBelongToProductionItemSetId(production_item,
+                                                 production_item_set_id);
   }
+  return result;
+}
+
+ProductionItemSetId SyntaxGenerator::GetProductionItemSetIdAfterTransform(
+    ProductionItemSetId production_item_set_id,
+    ProductionNodeId transform_node_id) {
+  SyntaxAnalysisTableEntry& syntax_analysis_table_entry =
+      GetSyntaxAnalysisTableEntry(
+          GetProductionItemSet(production_item_set_id)
+              .GetSyntaxAnalysisTableEntryId());
+  SyntaxAnalysisTableEntryId syntax_analysis_table_entry_id_after_transform;
+  if (GetProductionNode(transform_node_id).GetType() ==
+      ProductionNodeType::kNonTerminalNode) {
+    syntax_analysis_table_entry_id_after_transform =
+        syntax_analysis_table_entry.AtNonTerminalNode(transform_node_id);
+  } else {
+    syntax_analysis_table_entry_id_after_transform =
+        syntax_analysis_table_entry.AtTerminalNode(transform_node_id)
+            ->GetShiftAttachedData()
+            .GetNextSyntaxAnalysisTableEntryId();
+  }
+  return GetProductionItemSetIdFromSyntaxAnalysisTableEntryId(
+      syntax_analysis_table_entry_id_after_transform);
+}
+
+bool SyntaxGenerator::ProductionItemSetLr0Closure(
+    ProductionItemSetId production_item_set_id) {
+  ProductionItemSet& production_item_set =
+      GetProductionItemSet(production_item_set_id);
+  if (production_item_set.IsClosureAvailable()) {
+    // 闭包有效，无需重求
+    return false;
+  }
+  // 存储待展开的项
+  std::queue<ProductionItem> items_waiting_process;
+  for (auto& iter : GetProductionItemSetMainItems(production_item_set_id)) {
+    // 将项集中所有核心项压入待处理队列
+    items_waiting_process.push(iter->first);
+  }
+  while (!items_waiting_process.empty()) {
+    const auto [production_node_id, production_body_id,
+                next_word_to_shift_index] = items_waiting_process.front();
+    items_waiting_process.pop();
+    ProductionNodeId next_production_node_id = GetProductionNodeIdInBody(
+        production_node_id, production_body_id, next_word_to_shift_index);
+    if (!next_production_node_id.IsValid() ||
+        GetProductionNode(next_production_node_id).GetType() !=
+            ProductionNodeType::kNonTerminalNode) {
+      // 可以规约的项和下一个移入的符号为终结节点的项无需展开
+      continue;
+    }
+    NonTerminalProductionNode& next_production_node =
+        static_cast<NonTerminalProductionNode&>(
+            GetProductionNode(next_production_node_id));
+    for (auto body_id : next_production_node.GetAllBodyIds()) {
+      // 将该非终结节点中的每个产生式体加入到production_item_set中，点在最左侧
+      ProductionItem new_item(next_production_node_id, body_id,
+                              NextWordToShiftIndex(0));
+      if (production_item_set
+              .AddLr0Item(new_item, CreateForwardNodesContainer())
+              .second) {
+        items_waiting_process.push(std::move(new_item));
+      }
+    }
+    if (next_production_node.CouldBeEmptyReduct()) {
+      // ·右侧的非终结节点可以空规约，向项集中添加空规约后得到的项
+      ProductionItem new_item(
+          production_node_id, production_body_id,
+          NextWordToShiftIndex(next_word_to_shift_index + 1));
+      if (production_item_set
+              .AddLr0Item(new_item, CreateForwardNodesContainer())
+              .second) {
+        items_waiting_process.push(std::move(new_item));
+      }
+    }
+  }
+  SetProductionItemSetClosureAvailable(production_item_set_id);
+  LOG_INFO("SyntaxGenerator",
+           std::format("完成对ID = {:}的项集的LR(0)闭包操作",
+                       production_item_set_id.GetRawValue()));
   return true;
 }
 
+void SyntaxGenerator::Lr0ProductionItemSetConstruct(
+    ProductionItemSetId root_production_item_set_id) {
+  // 等待求闭包和转移表的项集ID
+  std::queue<ProductionItemSetId> production_item_set_waiting_process_ids;
+  production_item_set_waiting_process_ids.push(root_production_item_set_id);
+  while (!production_item_set_waiting_process_ids.empty()) {
+    ProductionItemSetId production_item_set_id =
+        production_item_set_waiting_process_ids.front();
+    production_item_set_waiting_process_ids.pop();
+    if (!ProductionItemSetLr0Closure(production_item_set_id)) {
+      continue;
+    }
+    // 项不携带向前看符号，转移到已有项集时不会添加向前看符号
+    // 所以返回的ID仅包含新建的项集
+    std::list<ProductionItemSetId> production_item_set_new_ids;
+    ProductionItemSetTransformConstruct(production_item_set_id,
+                                        &production_item_set_new_ids);
+    for (auto production_item_set_new_id : production_item_set_new_ids) {
+      production_item_set_waiting_process_ids.push(production_item_set_new_id);
+    }
+  }
+}
+
+void SyntaxGenerator::LalrLookForwardSymbolConstruct(
+    ProductionItemSetId root_production_item_set_id) {
+  // 所有非终结节点转移，值为转移前的项集ID和转移条件
+  std::vector<std::pair<ProductionItemSetId, ProductionNodeId>>
+      nonterminal_transforms;
+  // 项集ID -> 转移条件 -> 该转移在nonterminal_transforms中的下标
+  std::unordered_map<ProductionItemSetId,
+                     std::unordered_map<ProductionNodeId, size_t>>
+      nonterminal_transform_indexes;
+  ObjectManager<ProductionItemSet>::ConstIterator iter =
+      production_item_sets_.ConstBegin();
+  while (iter != production_item_sets_.ConstEnd()) {
+    ProductionItemSetId production_item_set_id = iter->GetProductionItemSetId();
+    auto& transform_indexes =
+        nonterminal_transform_indexes[production_item_set_id];
+    for (const auto& [item, forward_node_ids] :
+         iter->GetItemsAndForwardNodeIds()) {
+      const auto [production_node_id, production_body_id,
+                  next_word_to_shift_index] = item;
+      ProductionNodeId next_production_node_id = GetProductionNodeIdInBody(
+          production_node_id, production_body_id, next_word_to_shift_index);
+      if (next_production_node_id.IsValid() &&
+          GetProductionNode(next_production_node_id).GetType() ==
+              ProductionNodeType::kNonTerminalNode &&
+          transform_indexes
+              .emplace(next_production_node_id, nonterminal_transforms.size())
+              .second) {
+        nonterminal_transforms.emplace_back(production_item_set_id,
+                                            next_production_node_id);
+      }
+    }
+    ++iter;
+  }
+  const size_t nonterminal_transform_size = nonterminal_transforms.size();
+  // 每个转移的集合，依次存储DR、Read和Follow
+  // 初始项集的核心项作为虚拟转移追加在末尾
+  std::vector<ForwardNodesContainer> forward_node_sets(
+      nonterminal_transform_size, CreateForwardNodesContainer());
+  // 先存储reads关系，之后存储includes关系
+  std::vector<std::vector<size_t>> relation(nonterminal_transform_size);
+  for (size_t transform_index = 0; transform_index < nonterminal_transform_size;
+       transform_index++) {
+    auto [production_item_set_id, transform_node_id] =
+        nonterminal_transforms[transform_index];
+    ProductionItemSetId production_item_set_after_transform_id =
+        GetProductionItemSetIdAfterTransform(production_item_set_id,
+                                             transform_node_id);
+    const auto& transform_indexes =
+        nonterminal_transform_indexes[production_item_set_after_transform_id];
+    for (const auto& [item, forward_node_ids] :
+         GetProductionItemsAndForwardNodes(
+             production_item_set_after_transform_id)) {
+      const auto [production_node_id, production_body_id,
+                  next_word_to_shift_index] = item;
+      ProductionNodeId next_production_node_id = GetProductionNodeIdInBody(
+          production_node_id, production_body_id, next_word_to_shift_index);
+      if (!next_production_node_id.IsValid()) {
+        continue;
+      }
+      if (GetProductionNode(next_production_node_id).GetType() !=
+          ProductionNodeType::kNonTerminalNode) {
+        // DR：转移后可以直接移入的终结节点
+        forward_node_sets[transform_index].Set(
+            GetForwardNodeIndex(next_production_node_id));
+      } else if (IsNonTerminalNodeNullable(next_production_node_id)) {
+        // reads：转移后可以移入可空的非终结节点
+        relation[transform_index].push_back(
+            transform_indexes.at(next_production_node_id));
+      }
+    }
+  }
+  LalrDigraph(relation, &forward_node_sets);
+  for (auto& transform_relation : relation) {
+    transform_relation.clear();
+  }
+  // lookback关系，值为可以规约的项所在项集ID、该项和该项回溯到的转移下标
+  std::vector<std::tuple<ProductionItemSetId, ProductionItem, size_t>>
+      lookbacks;
+  // 从给定项集开始沿产生式体移入，建立includes和lookback关系
+  auto spread_along_production_body =
+      [&](ProductionItemSetId production_item_set_id,
+          ProductionNodeId production_node_id,
+          ProductionBodyId production_body_id,
+          NextWordToShiftIndex next_word_to_shift_index,
+          size_t transform_index) {
+        const auto& production_body =
+            GetProductionBody(production_node_id, production_body_id);
+        // 产生式体中每个位置之后的部分是否可空
+        std::vector<bool> suffix_nullable(production_body.size() + 1, true);
+        for (size_t index = production_body.size(); index-- > 0;) {
+          suffix_nullable[index] =
+              suffix_nullable[index + 1] &&
+              GetProductionNode(production_body[index]).GetType() ==
+                  ProductionNodeType::kNonTerminalNode &&
+              IsNonTerminalNodeNullable(production_body[index]);
+        }
+        // 当前可能到达的项集
+        std::vector<ProductionItemSetId> production_item_set_ids = {
+            production_item_set_id};
+        for (size_t index = next_word_to_shift_index;
+             index < production_body.size(); index++) {
+          ProductionNodeId next_production_node_id = production_body[index];
+          bool is_nonterminal_node =
+              GetProductionNode(next_production_node_id).GetType() ==
+              ProductionNodeType::kNonTerminalNode;
+          bool could_be_empty_reduct =
+              is_nonterminal_node &&
+              static_cast<NonTerminalProductionNode&>(
+                  GetProductionNode(next_production_node_id))
+                  .CouldBeEmptyReduct();
+          std::vector<ProductionItemSetId> production_item_set_after_shift_ids;
+          for (auto production_item_set_now_id : production_item_set_ids) {
+            if (is_nonterminal_node && suffix_nullable[index + 1]) {
+              // includes：·右侧非终结节点之后的部分可空
+              relation[nonterminal_transform_indexes[production_item_set_now_id]
+                           .at(next_production_node_id)]
+                  .push_back(transform_index);
+            }
+            production_item_set_after_shift_ids.push_back(
+                GetProductionItemSetIdAfterTransform(production_item_set_now_id,
+                                                     next_production_node_id));
+            if (could_be_empty_reduct) {
+              // 求闭包时已在原项集中添加空规约后得到的项
+              production_item_set_after_shift_ids.push_back(
+                  production_item_set_now_id);
+            }
+          }
+          std::sort(production_item_set_after_shift_ids.begin(),
+                    production_item_set_after_shift_ids.end());
+          production_item_set_after_shift_ids.erase(
+              std::unique(production_item_set_after_shift_ids.begin(),
+                          production_item_set_after_shift_ids.end()),
+              production_item_set_after_shift_ids.end());
+          production_item_set_ids =
+              std::move(production_item_set_after_shift_ids);
+        }
+        for (auto production_item_set_reduct_id : production_item_set_ids) {
+          lookbacks.emplace_back(
+              production_item_set_reduct_id,
+              ProductionItem(production_node_id, production_body_id,
+                             NextWordToShiftIndex(production_body.size())),
+              transform_index);
+        }
+      };
+  for (size_t transform_index = 0; transform_index < nonterminal_transform_size;
+       transform_index++) {
+    auto [production_item_set_id, transform_node_id] =
+        nonterminal_transforms[transform_index];
+    for (auto body_id : static_cast<NonTerminalProductionNode&>(
+                            GetProductionNode(transform_node_id))
+                            .GetAllBodyIds()) {
+      spread_along_production_body(production_item_set_id, transform_node_id,
+                                   body_id, NextWordToShiftIndex(0),
+                                   transform_index);
+    }
+  }
+  for (const auto& main_item_iter :
+       GetProductionItemSetMainItems(root_production_item_set_id)) {
+    // 初始项集的核心项作为虚拟转移，Read为核心项的向前看符号
+    const auto [production_node_id, production_body_id,
+                next_word_to_shift_index] = main_item_iter->first;
+    size_t transform_index = forward_node_sets.size();
+    forward_node_sets.push_back(main_item_iter->second);
+    relation.emplace_back();
+    spread_along_production_body(root_production_item_set_id,
+                                 production_node_id, production_body_id,
+                                 next_word_to_shift_index, transform_index);
+  }
+  LalrDigraph(relation, &forward_node_sets);
+  // 根据lookback关系设置规约操作
+  for (const auto& [production_item_set_id, production_item,
+                    transform_index] : lookbacks) {
+    ForwardNodesContainer&& added_forward_node_ids =
+        GetProductionItemSet(production_item_set_id)
+            .SpreadForwardNodesToItem(production_item,
+                                      forward_node_sets[transform_index]);
+    if (added_forward_node_ids.Empty()) {
+      continue;
+    }
+    const auto [production_node_id, production_body_id,
+                next_word_to_shift_index] = production_item;
+    SyntaxAnalysisTableEntry::ReductAttachedData reduct_attached_data(
+        production_node_id,
+        GetProcessFunctionClass(production_node_id, production_body_id),
+        GetProductionBody(production_node_id, production_body_id));
+    SyntaxAnalysisTableEntry& syntax_analysis_table_entry =
+        GetSyntaxAnalysisTableEntry(
+            GetProductionItemSet(production_item_set_id)
+                .GetSyntaxAnalysisTableEntryId());
+    added_forward_node_ids.ForEach([&](size_t forward_node_index) {
+      // 对每个向前看符号设置规约操作
+      syntax_analysis_table_entry.SetTerminalNodeActionAndAttachedData(
+          GetForwardNodeIdFromIndex(forward_node_index), reduct_attached_data);
+    });
+  }
+  LOG_INFO("SyntaxGenerator",
+           std::format("LALR(1)向前看符号计算完成，共{:}个非终结节点转移",
+                       nonterminal_transform_size));
+}
+
+void SyntaxGenerator::LalrDigraph(
+    const std::vector<std::vector<size_t>>& relation,
+    std::vector<ForwardNodesContainer>* forward_node_sets) {
+  assert(relation.size() == forward_node_sets->size());
+  // 已处理完毕的节点的深度
+  constexpr size_t kFinished = std::numeric_limits<size_t>::max();
+  // 节点入栈时的深度，0代表尚未访问
+  std::vector<size_t> depth(relation.size(), 0);
+  // 存储尚未确定所属强连通分量的节点
+  std::vector<size_t> node_stack;
+  // 模拟递归的调用栈，存储节点、节点入栈时的深度和下一个待处理的关系下标
+  std::vector<std::tuple<size_t, size_t, size_t>> call_stack;
+  auto& sets = *forward_node_sets;
+  for (size_t root = 0; root < relation.size(); root++) {
+    if (depth[root] != 0) {
+      continue;
+    }
+    node_stack.push_back(root);
+    depth[root] = node_stack.size();
+    call_stack.emplace_back(root, node_stack.size(), 0);
+    while (!call_stack.empty()) {
+      auto& [x, x_depth, relation_index] = call_stack.back();
+      if (relation_index < relation[x].size()) {
+        size_t y = relation[x][relation_index++];
+        if (depth[y] == 0) {
+          // 尚未访问过，模拟递归访问y
+          node_stack.push_back(y);
+          depth[y] = node_stack.size();
+          call_stack.emplace_back(y, node_stack.size(), 0);
+        } else {
+          depth[x] = std::min(depth[x], depth[y]);
+          sets[x].UnionWith(sets[y]);
+        }
+        continue;
+      }
+      // x的所有关系均已处理
+      size_t finished_x = x;
+      if (depth[finished_x] == x_depth) {
+        // x是强连通分量的根，分量内所有节点的集合相同
+        size_t top;
+        do {
+          top = node_stack.back();
+          node_stack.pop_back();
+          depth[top] = kFinished;
+          if (top != finished_x) {
+            sets[top] = sets[finished_x];
+          }
+        } while (top != finished_x);
+      }
+      call_stack.pop_back();
+      if (!call_stack.empty()) {
+        // 返回到调用者
+        size_t caller = std::get<0>(call_stack.back());
+        depth[caller] = std::min(depth[caller], depth[finished_x]);
+        sets[caller].UnionWith(sets[finished_x]);
+      }
+    }
+  }
+}
+
 std::array<std::vector<ProductionNodeId>, 4>
 SyntaxGenerator::ClassifyProductionNodes() const {
   std::array<std::vector<ProductionNodeId>, 4> production_nodes;
@@ -1340,6 +1846,8 @@ void SyntaxGenerator::SyntaxAnalysisTableMergeOptimize() {
 inline void SyntaxGenerator::SaveConfig(
     const std::string& config_file_output_path) const {
   dfa_generator_.SaveConfig(config_file_output_path);
+  dfa_generator_.SaveLexerSource(config_file_output_path);
+  dfa_generator_.SaveGenerationReport(config_file_output_path);
   std::ofstream config_file(
       config_file_output_path + frontend::common::kSyntaxConfigFileName,
       std::ios_base::binary | std::ios_base::out);
@@ -1406,14 +1914,15 @@ std::string SyntaxGenerator::FormatProductionItemAndLookForwardSymbols(
 
 std::string SyntaxGenerator::FormatLookForwardSymbols(
     const ForwardNodesContainer& look_forward_node_ids) const {
-  if (look_forward_node_ids.empty()) [[unlikely]] {
+  if (look_forward_node_ids.Empty()) [[unlikely]] {
     return std::string();
   }
   std::string format_result;
-  for (const auto& node_id : look_forward_node_ids) {
-    format_result += GetNodeSymbolStringFromProductionNodeId(node_id);
+  look_forward_node_ids.ForEach([&](size_t forward_node_index) {
+    format_result += GetNodeSymbolStringFromProductionNodeId(
+        GetForwardNodeIdFromIndex(forward_node_index));
     format_result += ' ';
-  }
+  });
   // 弹出尾部空格
   format_result.pop_back();
   return format_result;
@@ -1447,6 +1956,10 @@ void SyntaxGenerator::SyntaxAnalysisTableConstruct() {
   end_of_file_saved_data.production_node_id = end_production_node_id;
   end_of_file_saved_data.node_type = ProductionNodeType::kEndNode;
   dfa_generator_.SetEndOfFileSavedData(std::move(end_of_file_saved_data));
+  // 所有可以作为向前看符号的节点均已添加，为它们分配位集下标
+  ForwardNodeIndexConstruct();
+  // 语法已经完整，一次性计算所有非终结节点的FIRST集
+  NullableAndFirstSetConstruct();
   // 生成初始的项集，并将根产生式填入
   ProductionItemSetId root_production_item_set_id = EmplaceProductionItemSet();
   ProductionItemSet& root_production_item_set =
@@ -1457,15 +1970,29 @@ void SyntaxGenerator::SyntaxAnalysisTableConstruct() {
       AddNonTerminalProduction<RootReductClass>(
           "@RootNode",
           {GetNodeSymbolStringFromProductionNodeId(GetRootProductionNodeId())});
+  ForwardNodesContainer root_forward_node_ids = CreateForwardNodesContainer();
+  root_forward_node_ids.Set(GetForwardNodeIndex(end_production_node_id));
   root_production_item_set.AddMainItemAndForwardNodeIds(
       ProductionItem(inside_root_production_node_id, ProductionBodyId(0),
                      NextWordToShiftIndex(0)),
-      std::initializer_list<ProductionNodeId>{end_production_node_id});
+      std::move(root_forward_node_ids));
   SetRootSyntaxAnalysisTableEntryId(
       root_production_item_set.GetSyntaxAnalysisTableEntryId());
-  // 传播向前看符号同时构造语法分析表
-  SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
-      root_production_item_set_id);
+  switch (syntax_analysis_table_construct_mode_) {
+    case SyntaxAnalysisTableConstructMode::kSpreadLookForwardSymbol:
+      // 传播向前看符号同时构造语法分析表
+      SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
+          root_production_item_set_id);
+      break;
+    case SyntaxAnalysisTableConstructMode::kLalr:
+      // 构建LR(0)项集族后一次性计算LALR(1)向前看符号
+      Lr0ProductionItemSetConstruct(root_production_item_set_id);
+      LalrLookForwardSymbolConstruct(root_production_item_set_id);
+      break;
+    default:
+      assert(false);
+      break;
+  }
   // 设置内部根产生式遇到文件尾时可以接受，用来应对空输入的情况
   SyntaxAnalysisTableEntryId inside_root_syntax_analysis_entry_id =
       root_production_item_set.GetSyntaxAnalysisTableEntryId();
@@ -1483,11 +2010,19 @@ void SyntaxGenerator::SyntaxAnalysisTableConstruct() {
   SyntaxAnalysisTableMergeOptimize();
 }
 
-void SyntaxGenerator::ConstructSyntaxConfig() {
+void SyntaxGenerator::ConstructSyntaxConfig(
+    SyntaxAnalysisTableConstructMode construct_mode,
+    const std::string& dfa_profile_corpus_path,
+    size_t dfa_construct_thread_num) {
   SyntaxGeneratorInit();
+  syntax_analysis_table_construct_mode_ = construct_mode;
   ConfigConstruct();
   CheckUndefinedProductionRemained();
-  dfa_generator_.DfaConstruct();
+  dfa_generator_.DfaConstruct(dfa_construct_thread_num);
+  if (!dfa_profile_corpus_path.empty()) {
+    // 使用语料中的状态访问次数重新编号DFA状态，使热点状态连续存储
+    dfa_generator_.ProfileGuidedStateRenumber(dfa_profile_corpus_path);
+  }
   SyntaxAnalysisTableConstruct();
   // 保存配置
   SaveConfig();
@@ -1500,6 +2035,10 @@ void SyntaxGenerator::SyntaxGeneratorInit() {
   manager_terminal_body_symbol_.StructManagerInit();
   node_symbol_id_to_node_id_.clear();
   production_body_symbol_id_to_node_id_.clear();
+  production_node_id_to_forward_node_index_.clear();
+  forward_node_index_to_production_node_id_.clear();
+  nonterminal_node_first_sets_.clear();
+  nonterminal_node_nullable_.clear();
   production_item_sets_.ObjectManagerInit();
   syntax_analysis_table_entry_id_to_production_item_set_id_.clear();
   root_production_node_id_ = ProductionNodeId::InvalidId();
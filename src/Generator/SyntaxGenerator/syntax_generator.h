@@ -19,6 +19,7 @@
 #include <cassert>
 #include <format>
 #include <fstream>
+#include <queue>
 #include <regex>
 #include <tuple>
 
@@ -54,14 +55,33 @@ class SyntaxGenerator {
   using ForwardNodesContainer = ProductionItemSet::ForwardNodesContainer;
 
  public:
+  /// @brief 语法分析表的构建方式
+  enum class SyntaxAnalysisTableConstructMode {
+    /// @brief 构建项集的同时迭代传播向前看符号
+    kSpreadLookForwardSymbol,
+    /// @brief 先构建LR(0)项集族，再使用DeRemer-Pennello算法计算LALR(1)向前看符号
+    kLalr
+  };
+
   SyntaxGenerator() = default;
   SyntaxGenerator(const SyntaxGenerator&) = delete;
 
   SyntaxGenerator& operator=(const SyntaxGenerator&) = delete;
 
   /// @brief 构建并保存编译器前端配置
+  /// @param[in] construct_mode ：语法分析表的构建方式
+  /// @param[in] dfa_profile_corpus_path
+  /// ：有代表性的语料文件路径，为空则不重新编号DFA状态
+  /// @param[in] dfa_construct_thread_num ：DFA子集构造最多使用的线程数
   /// @note 自动构建语法分析和DFA配置并保存
-  void ConstructSyntaxConfig();
+  /// 两种构建方式的项集均按核心项合并，得到的语法分析表相同
+  /// 指定语料时按语料中各DFA状态的访问次数重新编号状态，使热点状态连续存储
+  /// 默认串行构建DFA，生成的DFA配置与线程数无关
+  void ConstructSyntaxConfig(
+      SyntaxAnalysisTableConstructMode construct_mode =
+          SyntaxAnalysisTableConstructMode::kSpreadLookForwardSymbol,
+      const std::string& dfa_profile_corpus_path = std::string(),
+      size_t dfa_construct_thread_num = 1);
 
  private:
   /// @brief 初始化
@@ -70,6 +90,7 @@ class SyntaxGenerator {
   /// @note 该函数定义在config_construct.cpp中
   void ConfigConstruct();
   /// @brief 构建语法分析表
+  /// @note 根据syntax_analysis_table_construct_mode_选择构建方式
   void SyntaxAnalysisTableConstruct();
 
   /// @brief 添加产生式名
@@ -546,7 +567,7 @@ class SyntaxGenerator {
   /// @param[in] forward_node_ids ：核心项的向前看符号
   /// @return 前半部分为插入的位置，后半部分为是否插入新项
   /// @note
-  /// 1.forward_node_ids支持存储ID的容器也支持未包装的ID
+  /// 1.forward_node_ids为存储向前看符号的位集
   /// 2.如果添加了新向前看符号则设置闭包无效
   /// 3.如果给定项已存在则返回值后半部分一定返回false
   /// 4.添加了新项则自动更新该项所存在的项集的ID的记录
@@ -565,7 +586,7 @@ class SyntaxGenerator {
   /// @retval true ：添加了新的向前看符号
   /// @retval false ：未添加新的向前看符号
   /// @note
-  /// 1.forward_node_ids支持存储ID的容器也支持未包装的ID
+  /// 1.forward_node_ids为存储向前看符号的位集
   /// 2.要求项已经存在，否则应调用AddItemAndForwardNodeIds或同类函数
   /// 3.如果添加了新的向前看符号则设置闭包无效
   /// 4.production_item必须是核心项
@@ -577,6 +598,17 @@ class SyntaxGenerator {
         .AddForwardNodes(production_item, std::forward<ForwardNodeIdContainer>(
                                               forward_node_ids));
   }
+  /// @brief 向项集中添加不携带向前看符号的核心项
+  /// @param[in] production_item_set_id ：项集ID
+  /// @param[in] production_item ：核心项
+  /// @return 前半部分为插入的位置，后半部分为是否插入新项
+  /// @note
+  /// 1.仅用于LALR(1)模式下构建LR(0)项集族
+  /// 2.添加了新项则自动更新该项所存在的项集的ID的记录
+  /// @attention 不允许对已求过闭包的项集执行该操作
+  std::pair<ProductionItemAndForwardNodesContainer::iterator, bool>
+  AddLr0MainItemToProductionItem(ProductionItemSetId production_item_set_id,
+                                 const ProductionItem& production_item);
   /// @brief 添加核心项所属的项集ID
   /// @param[in] production_item ：项
   /// @param[in] production_item_set_id ：项集ID
@@ -618,22 +650,59 @@ class SyntaxGenerator {
         .at(production_item);
   }
 
-  /// @brief First的子过程，提取一个非终结节点全部第一个可移入的产生式节点ID
-  /// @param[in] production_node_id ：非终结产生式节点ID
-  /// @param[in,out] result ：存储提取到的节点ID
-  /// @param[in,out] processed_nodes ：已提取的非终结产生式节点
+  /// @brief 为所有可以作为向前看符号的节点分配向前看符号位集中的下标
   /// @details
-  /// 提取可以规约为给定非终结产生式的所有产生式组合中每个组合的第一个产生式ID
-  /// 提取到的所有节点ID存到result中
-  /// @note
-  /// 1.processed_nodes存储已经提取过的产生式节点ID，这些节点不会被再次提取
-  /// 2.该函数只会将结果添加到result中，不会清空result已有的内容
-  /// @attention
-  /// production_node_id必须有效，result不接受nullptr
-  void GetNonTerminalNodeFirstNodeIds(
-      ProductionNodeId production_node_id, ForwardNodesContainer* result,
-      std::unordered_set<ProductionNodeId>&& processed_nodes =
-          std::unordered_set<ProductionNodeId>());
+  /// 终结节点、运算符节点和文件尾节点按节点ID升序编号为[0,向前看符号总数)
+  /// @note 应在添加文件尾节点后、构建语法分析表前调用
+  void ForwardNodeIndexConstruct();
+  /// @brief 获取向前看符号在向前看符号位集中的下标
+  /// @param[in] production_node_id ：终结节点/运算符节点/文件尾节点ID
+  /// @return 返回向前看符号位集中的下标
+  size_t GetForwardNodeIndex(ProductionNodeId production_node_id) const {
+    assert(production_node_id <
+           production_node_id_to_forward_node_index_.size());
+    assert(production_node_id_to_forward_node_index_[production_node_id] !=
+           std::numeric_limits<size_t>::max());
+    return production_node_id_to_forward_node_index_[production_node_id];
+  }
+  /// @brief 获取向前看符号位集中的下标对应的节点ID
+  /// @param[in] forward_node_index ：向前看符号位集中的下标
+  /// @return 返回节点ID
+  ProductionNodeId GetForwardNodeIdFromIndex(size_t forward_node_index) const {
+    assert(forward_node_index <
+           forward_node_index_to_production_node_id_.size());
+    return forward_node_index_to_production_node_id_[forward_node_index];
+  }
+  /// @brief 创建空的向前看符号集
+  /// @return 返回位数为向前看符号总数的空位集
+  ForwardNodesContainer CreateForwardNodesContainer() const {
+    return ForwardNodesContainer(
+        forward_node_index_to_production_node_id_.size());
+  }
+  /// @brief 计算所有非终结节点的FIRST集和是否可以推导出空串
+  /// @details
+  /// 不动点迭代：反复扫描所有产生式体，用产生式体可空前缀中各节点的FIRST集
+  /// 更新产生式头的FIRST集，直到所有FIRST集和可空标记都不再变化
+  /// 非终结节点可空的条件为用户设置了可以空规约或存在所有节点均可空的产生式体
+  /// @note 应在ForwardNodeIndexConstruct之后、构建语法分析表前调用
+  void NullableAndFirstSetConstruct();
+  /// @brief 获取非终结节点的FIRST集
+  /// @param[in] production_node_id ：非终结产生式节点ID
+  /// @return 返回FIRST集的const引用
+  /// @note 要求已调用NullableAndFirstSetConstruct
+  const ForwardNodesContainer& GetNonTerminalNodeFirstSet(
+      ProductionNodeId production_node_id) const {
+    assert(production_node_id < nonterminal_node_first_sets_.size());
+    return nonterminal_node_first_sets_[production_node_id];
+  }
+  /// @brief 查询非终结节点是否可以推导出空串
+  /// @param[in] production_node_id ：非终结产生式节点ID
+  /// @return 返回是否可以推导出空串
+  /// @note 要求已调用NullableAndFirstSetConstruct
+  bool IsNonTerminalNodeNullable(ProductionNodeId production_node_id) const {
+    assert(production_node_id < nonterminal_node_nullable_.size());
+    return nonterminal_node_nullable_[production_node_id];
+  }
   /// @brief 闭包操作中的first操作，用来提取非终结产生式的向前看节点
   /// @param[in] production_node_id ：非终结产生式节点ID
   /// @param[in] production_body_id ：非终结产生式体ID
@@ -646,13 +715,14 @@ class SyntaxGenerator {
   /// @details
   /// 1.production_node_id、production_body_id和next_word_to_shift_index标志
   /// β的位置（提取向前看符号的位置）
-  /// 2.自动递归处理可以空规约的非终结产生式
+  /// 2.使用NullableAndFirstSetConstruct预先计算的FIRST集，
+  /// 时间复杂度为O(|β|)
   /// 3.因为非终结节点可能空规约，需要向下查找产生式，
   /// 所以前三个参数不能合并为待展开的产生式ID
   ForwardNodesContainer First(ProductionNodeId production_node_id,
                               ProductionBodyId production_body_id,
                               NextWordToShiftIndex next_word_to_shift_index,
-                              const ForwardNodesContainer& next_node_ids);
+                              const ForwardNodesContainer& next_node_ids) const;
   /// @brief 获取项集的全部项和项的向前看符号
   /// @param[in] production_item_set_id ：项集ID
   /// @return 返回存储项和对应向前看符号的容器的const引用
@@ -682,7 +752,7 @@ class SyntaxGenerator {
   /// @param[in] production_item_set_id ：项集ID
   /// @note
   /// 闭包有效的项集在调用ProductionItemSetClosure时直接返回，不会重求闭包
-  /// @attention 仅应由ProductionItemSetClosure调用
+  /// @attention 仅应由ProductionItemSetClosure和ProductionItemSetLr0Closure调用
   void SetProductionItemSetClosureAvailable(
       ProductionItemSetId production_item_set_id) {
     GetProductionItemSet(production_item_set_id).SetClosureAvailable();
@@ -702,9 +772,34 @@ class SyntaxGenerator {
   /// @retval false ：闭包有效，无需重求
   /// @note
   /// 1.自动添加所有当前位置可以空规约的项的后续项
-  /// 2.重求闭包前会清空语法分析表条目和非核心项
+  /// 2.重求闭包前会清空语法分析表条目、非核心项和待传播的向前看符号
   /// 3.求闭包过程中自动填写语法分析表中可规约的项
   bool ProductionItemSetClosure(ProductionItemSetId production_item_set_id);
+  /// @brief 在项集内部传播向前看符号
+  /// @param[in] production_item_set_id ：项集ID
+  /// @param[in] items_waiting_spread ：待传播的项和该项新增的向前看符号
+  /// @param[out] production_item_set_changed_ids
+  /// ：存储核心项获得新向前看符号的项集ID，可能重复
+  /// @details
+  /// 1.每个项仅向下传播本次新增的向前看符号，项获得新的向前看符号时重新入队，
+  /// 直到所有项的向前看符号都不再变化
+  /// 2.可以规约的项在新增的向前看符号下设置规约操作
+  /// 3.production_item_set_changed_ids不为nullptr时项集转移表已建立，
+  /// 同时将新增的向前看符号传播到移入下一个节点后到达的项集的核心项
+  /// @note 项集转移表未建立时（求闭包）允许插入新项
+  void SpreadForwardNodesInProductionItemSet(
+      ProductionItemSetId production_item_set_id,
+      std::queue<std::pair<ProductionItem, ForwardNodesContainer>>&&
+          items_waiting_spread,
+      std::list<ProductionItemSetId>* production_item_set_changed_ids);
+  /// @brief 传播项集核心项新增的向前看符号
+  /// @param[in] production_item_set_id ：项集ID
+  /// @param[out] production_item_set_changed_ids
+  /// ：存储核心项获得新向前看符号的项集ID，可能重复
+  /// @note 要求项集已求过闭包并建立转移表
+  void SpreadPendingForwardNodes(
+      ProductionItemSetId production_item_set_id,
+      std::list<ProductionItemSetId>* production_item_set_changed_ids);
   /// @brief 获取给定项移入相同产生式后构成的项集
   /// @param[in] items ：指向转移前的项的迭代器
   /// @return 返回获取到的项集ID
@@ -713,18 +808,72 @@ class SyntaxGenerator {
   /// @details
   /// 查找项集，给定项移入相同产生式后该项集有且仅有这些项是核心项
   ProductionItemSetId GetProductionItemSetIdFromProductionItems(
-      const std::list<std::unordered_map<
-          ProductionItem, std::unordered_set<ProductionNodeId>,
-          ProductionItemSet::ProductionItemHasher>::const_iterator>& items);
-  /// @brief 传播向前看符号，同时在传播过程中构建语法分析表shift操作的部分
-  /// @param[in] production_item_set_id ：待传播向前看符号的项集ID
-  /// @return 返回是否执行了传播过程
-  /// @retval true ：执行了传播向前看符号的过程
-  /// @retval false ：无需执行传播向前看符号的过程
+      const std::list<ProductionItemAndForwardNodesContainer::const_iterator>&
+          items);
+  /// @brief 建立项集的转移表并向转移到的项集传播向前看符号，
+  /// 同时构建语法分析表shift操作的部分
+  /// @param[in] production_item_set_id ：已求过闭包的项集ID
+  /// @param[out] production_item_set_changed_ids
+  /// ：存储新建的项集和核心项获得新向前看符号的项集ID，可能重复
+  void ProductionItemSetTransformConstruct(
+      ProductionItemSetId production_item_set_id,
+      std::list<ProductionItemSetId>* production_item_set_changed_ids);
+  /// @brief 传播向前看符号，同时在传播过程中构建语法分析表
+  /// @param[in] root_production_item_set_id ：初始项集ID
   /// @details
-  /// 闭包有效说明该项集和对应的语法分析表条目未修改，无需重新传播向前看符号
-  bool SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
-      ProductionItemSetId production_item_set_id);
+  /// 使用去重的工作队列迭代处理项集：
+  /// 1.新项集求闭包后建立转移表
+  /// 2.已建立转移表的项集仅传播核心项新增的向前看符号
+  /// 处理过程中新建的项集和核心项获得新向前看符号的项集入队，
+  /// 同一个项集在队列中最多出现一次，直到队列为空
+  void SpreadLookForwardSymbolAndConstructSyntaxAnalysisTableEntry(
+      ProductionItemSetId root_production_item_set_id);
+  /// @brief 获取项集移入给定节点后转移到的项集
+  /// @param[in] production_item_set_id ：已建立转移表的项集ID
+  /// @param[in] transform_node_id ：转移条件节点ID
+  /// @return 返回转移到的项集ID
+  /// @note 要求该项集存在给定节点的转移
+  ProductionItemSetId GetProductionItemSetIdAfterTransform(
+      ProductionItemSetId production_item_set_id,
+      ProductionNodeId transform_node_id);
+  /// @brief 对项集求LR(0)闭包
+  /// @param[in] production_item_set_id ：项集ID
+  /// @return 返回是否求了闭包
+  /// @retval true ：求了闭包
+  /// @retval false ：闭包有效，无需重求
+  /// @note
+  /// 1.自动添加所有当前位置可以空规约的项的后续项
+  /// 2.非核心项不携带向前看符号，不填写语法分析表中的规约操作
+  bool ProductionItemSetLr0Closure(ProductionItemSetId production_item_set_id);
+  /// @brief 构建LR(0)项集族和语法分析表中的移入/转移部分
+  /// @param[in] root_production_item_set_id ：初始项集ID
+  /// @note 使用工作队列处理新建的项集，每个项集仅求一次闭包和转移表
+  void Lr0ProductionItemSetConstruct(
+      ProductionItemSetId root_production_item_set_id);
+  /// @brief 使用DeRemer-Pennello算法计算LALR(1)向前看符号并填写规约操作
+  /// @param[in] root_production_item_set_id ：初始项集ID
+  /// @details
+  /// 1.DR(p,A)：p移入A后到达的项集中可以移入的终结节点
+  /// 2.(p,A) reads (r,C)：p移入A后到达r，r可以移入可空的非终结节点C
+  /// 3.(p,A) includes (p',B)：存在B->βAγ，γ可空且p'移入β后到达p
+  /// 4.(q,A->ω) lookback (p,A)：p移入ω后到达q
+  /// 5.Read = DR ∪ {Read(r,C) | (p,A) reads (r,C)}，
+  /// Follow = Read ∪ {Follow(p',B) | (p,A) includes (p',B)}，
+  /// LA(q,A->ω) = ∪{Follow(p,A) | (q,A->ω) lookback (p,A)}
+  /// 6.初始项集的核心项作为虚拟的非终结节点转移，Read为核心项的向前看符号
+  /// @note
+  /// 1.要求已调用Lr0ProductionItemSetConstruct
+  /// 2.移入可以空规约的非终结节点时同时保留在原项集中，与求闭包时添加的后续项对应
+  /// 3.仅可以规约的项记录向前看符号
+  void LalrLookForwardSymbolConstruct(
+      ProductionItemSetId root_production_item_set_id);
+  /// @brief DeRemer-Pennello算法中的digraph过程
+  /// @param[in] relation ：relation[x]存储与x存在关系的全部y
+  /// @param[in,out] forward_node_sets ：传入每个x的初始集合，
+  /// 返回F(x) = F'(x) ∪ {F(y) | x relation y}
+  /// @note 使用显式栈模拟递归，同一个强连通分量内的集合相同
+  static void LalrDigraph(const std::vector<std::vector<size_t>>& relation,
+                          std::vector<ForwardNodesContainer>* forward_node_sets);
   /// @brief 对所有产生式节点按照ProductionNodeType分类
   /// @return 返回存储不同类型节点的容器
   /// @note
@@ -791,7 +940,8 @@ class SyntaxGenerator {
   /// ：配置文件输出路径（不含文件名，以'/'结尾）
   /// @details 在指定路径处输出语法分析表和词法分析表，
   /// 语法分析表配置文件名为frontend::common::kSyntaxConfigFileName，
-  /// 词法分析表配置文件名为frontend::common::kDfaConfigFileName
+  /// 词法分析表配置文件名为frontend::common::kDfaConfigFileName，
+  /// 直接编码的词法分析机源文件名为frontend::common::kDfaLexerSourceFileName
   void SaveConfig(const std::string& config_file_output_path = "./") const;
 
   /// @brief 格式化产生式
@@ -893,6 +1043,16 @@ class SyntaxGenerator {
   /// @brief 终结产生式体符号ID到对应节点ID的映射
   std::unordered_map<SymbolId, ProductionNodeId>
       production_body_symbol_id_to_node_id_;
+  /// @brief 节点ID到向前看符号位集中的下标的映射
+  /// @note 不能作为向前看符号的节点对应std::numeric_limits<size_t>::max()
+  std::vector<size_t> production_node_id_to_forward_node_index_;
+  /// @brief 向前看符号位集中的下标到节点ID的映射
+  std::vector<ProductionNodeId> forward_node_index_to_production_node_id_;
+  /// @brief 非终结节点的FIRST集，下标为节点ID
+  /// @note 其余类型的节点对应空位集
+  std::vector<ForwardNodesContainer> nonterminal_node_first_sets_;
+  /// @brief 非终结节点是否可以推导出空串，下标为节点ID
+  std::vector<bool> nonterminal_node_nullable_;
   /// @brief 存储项集
   ObjectManager<ProductionItemSet> production_item_sets_;
   /// @brief 存储语法分析表条目ID到项集ID的映射
@@ -900,6 +1060,9 @@ class SyntaxGenerator {
       syntax_analysis_table_entry_id_to_production_item_set_id_;
   /// @brief 用户定义的根非终结产生式节点ID
   ProductionNodeId root_production_node_id_ = ProductionNodeId::InvalidId();
+  /// @brief 语法分析表的构建方式
+  SyntaxAnalysisTableConstructMode syntax_analysis_table_construct_mode_ =
+      SyntaxAnalysisTableConstructMode::kSpreadLookForwardSymbol;
   /// @brief 初始语法分析表条目ID，配置写入文件
   SyntaxAnalysisTableEntryId root_syntax_analysis_table_entry_id_;
   /// @brief 语法分析表，配置写入文件
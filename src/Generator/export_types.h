@@ -5,6 +5,8 @@
 
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -205,9 +207,273 @@ enum class WrapperLabel { kTransformArrayId };
 using TransformArrayId =
     frontend::common::ExplicitIdWrapper<size_t, WrapperLabel,
                                         WrapperLabel::kTransformArrayId>;
-/// @brief 转移表条目
-using TransformArray = TransformArrayManager<TransformArrayId>;
+
+/// @class ByteRanges export_types.h
+/// @brief 若干个闭区间表示的字节集合
+/// @details 字节按unsigned char比较；用于SIMD批量判断字节是否属于集合
+struct ByteRanges {
+  /// @brief 最多存储的区间数目
+  static constexpr size_t kMaxRangeNum = 4;
+
+  /// @brief 允许序列化类访问
+  friend class boost::serialization::access;
+
+  /// @brief 序列化配置的函数
+  /// @param[in,out] ar ：序列化使用的档案
+  /// @param[in] version ：序列化文件版本
+  /// @attention 该函数应由boost库调用而非手动调用
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar& range_num;
+    ar& range_begin;
+    ar& range_end;
+  }
+
+  /// @brief 有效区间数目，为0代表集合为空
+  uint8_t range_num = 0;
+  /// @brief 每个区间的起始字节（包含）
+  std::array<uint8_t, kMaxRangeNum> range_begin = {};
+  /// @brief 每个区间的结束字节（包含）
+  std::array<uint8_t, kMaxRangeNum> range_end = {};
+};
+
+/// @class DfaConfig export_types.h
+/// @brief 按字节等价类压缩后的DFA配置
+/// @details
+/// 1.在所有状态下转移结果都相同的字节属于同一个等价类，转移表只为每个等价类
+/// 存储一列，C语言等文法通常只有几十个等价类
+/// 2.转移表为稠密的state_num*class_num的uint16_t数组，按状态行优先存储，
+/// 状态编号即TransformArrayId的值
+/// 3.查询转移时先通过256字节的char_to_class查询等价类再查转移表
+/// 4.self_loop_ranges存储每个状态转移到自身的字节集合，解析器据此使用SIMD
+/// 一次移入一批字符（如标识符中的[a-zA-Z0-9_]*）
+struct DfaConfig {
+  /// @brief 转移表中存储的状态编号类型
+  using StateIndex = uint16_t;
+  /// @brief 转移表中表示无法转移的值
+  static constexpr StateIndex kInvalidStateIndex = UINT16_MAX;
+  /// @brief 可表示的最大状态数目（不含kInvalidStateIndex）
+  static constexpr size_t kMaxStateNum = kInvalidStateIndex;
+
+  /// @brief 允许序列化类访问
+  friend class boost::serialization::access;
+
+  /// @brief 序列化配置的函数
+  /// @param[in,out] ar ：序列化使用的档案
+  /// @param[in] version ：序列化文件版本
+  /// @attention 该函数应由boost库调用而非手动调用
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar& char_to_class;
+    ar& class_num;
+    ar& transform_table;
+    ar& word_attached_data;
+    ar& self_loop_ranges;
+  }
+
+  /// @brief 获取状态在给定字符下转移到的状态
+  /// @param[in] state ：转移起点状态
+  /// @param[in] c_transform ：转移条件
+  /// @return 返回转移到的状态
+  /// @retval kInvalidStateIndex ：无法转移
+  StateIndex Transform(StateIndex state, char c_transform) const {
+    return transform_table[state * class_num +
+                           char_to_class[static_cast<unsigned char>(
+                               c_transform)]];
+  }
+  /// @brief 获取状态数目
+  /// @return 返回状态数目
+  size_t GetStateNum() const { return word_attached_data.size(); }
+
+  /// @brief 字符到等价类编号的映射，使用unsigned char作为下标
+  std::array<uint8_t, frontend::common::kCharNum> char_to_class;
+  /// @brief 等价类数目，也是转移表每行的条目数
+  size_t class_num = 0;
+  /// @brief 转移表，下标为状态编号*class_num+等价类编号
+  std::vector<StateIndex> transform_table;
+  /// @brief 每个状态对应单词的附属数据，下标为状态编号
+  std::vector<WordAttachedData> word_attached_data;
+  /// @brief 每个状态转移到自身的字节集合，下标为状态编号
+  /// @note 无法用ByteRanges::kMaxRangeNum个区间表示的集合存储为空集合
+  std::vector<ByteRanges> self_loop_ranges;
+};
+
+/// @class CombDfaConfig export_types.h
+/// @brief 使用行位移（梳状）压缩存储转移表的DFA配置
+/// @details
+/// 1.与lex/yacc的base/check/next表相同，状态state在等价类class_id下的条目
+/// 存储在下标base[state]+class_id处，check中存储该位置所属的状态，
+/// 各状态的行相互交错填入next/check的空位
+/// 2.每个状态可以指定默认状态，只存储与默认状态转移结果不同的条目，
+/// 查询不到的条目沿default_state链继续查询，到达链尾时无法转移
+/// 3.默认状态的转移结果为kInvalidStateIndex而本状态可以转移的条目
+/// 存储为next等于kInvalidStateIndex的条目
+/// 4.char_to_class、word_attached_data和self_loop_ranges与DfaConfig相同
+struct CombDfaConfig {
+  /// @brief 转移表中存储的状态编号类型
+  using StateIndex = DfaConfig::StateIndex;
+  /// @brief 转移表中表示无法转移的值，也用于表示check中的空位和没有默认状态
+  static constexpr StateIndex kInvalidStateIndex = DfaConfig::kInvalidStateIndex;
+  /// @brief 可表示的最大状态数目（不含kInvalidStateIndex）
+  static constexpr size_t kMaxStateNum = DfaConfig::kMaxStateNum;
+
+  /// @brief 允许序列化类访问
+  friend class boost::serialization::access;
+
+  /// @brief 序列化配置的函数
+  /// @param[in,out] ar ：序列化使用的档案
+  /// @param[in] version ：序列化文件版本
+  /// @attention 该函数应由boost库调用而非手动调用
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar& char_to_class;
+    ar& class_num;
+    ar& base;
+    ar& default_state;
+    ar& next;
+    ar& check;
+    ar& word_attached_data;
+    ar& self_loop_ranges;
+  }
+
+  /// @brief 获取状态在给定字符下转移到的状态
+  /// @param[in] state ：转移起点状态
+  /// @param[in] c_transform ：转移条件
+  /// @return 返回转移到的状态
+  /// @retval kInvalidStateIndex ：无法转移
+  StateIndex Transform(StateIndex state, char c_transform) const {
+    const size_t class_id =
+        char_to_class[static_cast<unsigned char>(c_transform)];
+    do {
+      const size_t index = base[state] + class_id;
+      if (check[index] == state) {
+        return next[index];
+      }
+      state = default_state[state];
+    } while (state != kInvalidStateIndex);
+    return kInvalidStateIndex;
+  }
+  /// @brief 获取状态数目
+  /// @return 返回状态数目
+  size_t GetStateNum() const { return word_attached_data.size(); }
+
+  /// @brief 字符到等价类编号的映射，使用unsigned char作为下标
+  std::array<uint8_t, frontend::common::kCharNum> char_to_class;
+  /// @brief 等价类数目
+  size_t class_num = 0;
+  /// @brief 每个状态的行在next/check中的起始下标，下标为状态编号
+  std::vector<uint32_t> base;
+  /// @brief 每个状态的默认状态，下标为状态编号
+  /// @note 没有默认状态时为kInvalidStateIndex
+  std::vector<StateIndex> default_state;
+  /// @brief 条目转移到的状态
+  /// @note 长度保证任意base[state]+class_id都不越界
+  std::vector<StateIndex> next;
+  /// @brief 条目所属的状态，空位为kInvalidStateIndex
+  std::vector<StateIndex> check;
+  /// @brief 每个状态对应单词的附属数据，下标为状态编号
+  std::vector<WordAttachedData> word_attached_data;
+  /// @brief 每个状态转移到自身的字节集合，下标为状态编号
+  /// @note 无法用ByteRanges::kMaxRangeNum个区间表示的集合存储为空集合
+  std::vector<ByteRanges> self_loop_ranges;
+};
+
 /// @brief DFA配置类型
-using DfaConfigType = std::vector<std::pair<TransformArray, WordAttachedData>>;
+/// @note 定义USE_COMB_DFA_TABLE时配置文件和DfaParser使用行位移压缩的转移表
+#ifdef USE_COMB_DFA_TABLE
+using DfaConfigType = CombDfaConfig;
+#else
+using DfaConfigType = DfaConfig;
+#endif  // USE_COMB_DFA_TABLE
+
+/// @class LazyDfaConfig export_types.h
+/// @brief 压缩编号后的NFA，用于子集构造和运行时按需构建DFA（惰性DFA）
+/// @details
+/// 1.可达的NFA节点和闭包（从节点出发通过无条件转移可以到达的节点集合）
+/// 分别使用从0开始的连续编号
+/// 2.第i个节点的条件转移存储在transfers的
+/// [transfer_offsets[i], transfer_offsets[i+1])中，按low从小到大排列
+/// 3.第i个闭包包含的节点存储在closure_members的
+/// [closure_member_offsets[i], closure_member_offsets[i+1])中
+/// 4.所有条件转移范围的边界将字节划分为等价类，同一等价类内的字节在任何
+/// 状态下转移结果都相同
+struct LazyDfaConfig {
+  /// @class RangeTransfer export_types.h
+  /// @brief NFA节点的条件转移条目，移入[low, high]内的字节后转移到编号为
+  /// closure_index的闭包
+  /// @note 字节按unsigned char比较
+  struct RangeTransfer {
+    /// @brief 允许序列化类访问
+    friend class boost::serialization::access;
+
+    /// @brief 序列化配置的函数
+    /// @param[in,out] ar ：序列化使用的档案
+    /// @param[in] version ：序列化文件版本
+    /// @attention 该函数应由boost库调用而非手动调用
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int version) {
+      ar& low;
+      ar& high;
+      ar& closure_index;
+    }
+
+    uint8_t low;
+    uint8_t high;
+    uint32_t closure_index;
+  };
+
+  /// @brief 允许序列化类访问
+  friend class boost::serialization::access;
+
+  /// @brief 序列化配置的函数
+  /// @param[in,out] ar ：序列化使用的档案
+  /// @param[in] version ：序列化文件版本
+  /// @attention 该函数应由boost库调用而非手动调用
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int version) {
+    ar& transfer_offsets;
+    ar& transfers;
+    ar& closure_member_offsets;
+    ar& closure_members;
+    ar& closure_word_attached_data;
+    ar& closure_word_priority;
+    ar& root_closure;
+    ar& char_to_class;
+    ar& class_num;
+  }
+
+  /// @brief 获取NFA节点数目
+  /// @return 返回NFA节点数目
+  size_t GetNodeNum() const { return transfer_offsets.size() - 1; }
+  /// @brief 获取闭包数目
+  /// @return 返回闭包数目
+  size_t GetClosureNum() const { return closure_word_attached_data.size(); }
+  /// @brief 判断闭包是否代表单词
+  /// @param[in] closure_index ：闭包编号
+  /// @return 返回闭包是否包含尾节点
+  bool IsWordClosure(size_t closure_index) const {
+    return closure_word_priority[closure_index].IsValid();
+  }
+
+  /// @brief 每个节点的条件转移在transfers中的起始下标，共GetNodeNum()+1项
+  std::vector<uint32_t> transfer_offsets = {0};
+  /// @brief 所有节点的条件转移
+  std::vector<RangeTransfer> transfers;
+  /// @brief 每个闭包的节点在closure_members中的起始下标，共GetClosureNum()+1项
+  std::vector<uint32_t> closure_member_offsets = {0};
+  /// @brief 所有闭包包含的节点编号
+  std::vector<uint32_t> closure_members;
+  /// @brief 每个闭包代表的最高优先级的单词的附属数据，下标为闭包编号
+  std::vector<WordAttachedData> closure_word_attached_data;
+  /// @brief 每个闭包代表的最高优先级的单词的优先级，下标为闭包编号
+  /// @note 闭包不代表任何单词时为WordPriority::InvalidId()
+  std::vector<nfa_generator::WordPriority> closure_word_priority;
+  /// @brief NFA头结点的闭包编号
+  uint32_t root_closure = 0;
+  /// @brief 字节到等价类编号的映射，使用unsigned char作为下标
+  std::array<uint8_t, frontend::common::kCharNum> char_to_class = {};
+  /// @brief 等价类数目
+  size_t class_num = 1;
+};
 }  // namespace frontend::generator::dfa_generator
 #endif  /// !COMMON_ENUM_AND_TYPES_H_
\ No newline at end of file
@@ -1,85 +1,320 @@
 ﻿#include "Parser/DfaParser/dfa_parser.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <format>
+#include <thread>
 
 #define ENABLE_LOG
 #include "Logger/logger.h"
 
 namespace frontend::parser::dfa_parser {
+/// @brief 连续至少这么多个字符属于字节集合时才调用SIMD函数
+/// @note 过短的连续字符调用SIMD函数的开销高于逐字节处理
+constexpr ptrdiff_t kMinSpanLength = 2;
+
 bool DfaParser::SetInputFile(const std::string filename) {
-  FILE* file;
-  fopen_s(&file, filename.c_str(), "r");
-  if (file == nullptr) {
+  if (!input_file_.Open(filename)) {
     return false;
   } else {
-    file_ = file;
-    SetCharacterNow(fgetc(file_));
+    std::string_view content = input_file_.GetContent();
+    input_begin_ = content.data();
+    character_now_ = content.data();
+    input_end_ = content.data() + content.size();
+    SetInput(content);
     return true;
   }
 }
 
-DfaParser::WordInfo DfaParser::GetNextWord() {
-  std::string symbol;
-  WordInfo return_data;
-  // 当前状态转移表ID
-  TransformArrayId transform_array_id = root_transform_array_id_;
+void DfaParser::SetInputBuffer(std::string_view input_buffer) {
+  // 关闭之前的输入文件，释放映射的内存
+  input_file_.Close();
+  input_begin_ = input_buffer.data();
+  character_now_ = input_buffer.data();
+  input_end_ = input_buffer.data() + input_buffer.size();
+  SetInput(input_buffer);
+}
+
+inline DfaParser::MatchedWord DfaParser::MatchWord(
+    const char* character_now,
+    [[maybe_unused]] MatchCache& match_cache) const {
+  const char* const input_end = input_end_;
   // 跳过空白字符
-  while (std::isspace(GetCharacterNow())) {
-    if (GetCharacterNow() == '\n') [[unlikely]] {
-      // 行数+1
-      SetLine(GetLine() + 1);
-      // 重置列数为0
-      SetColumn(0);
+  // 先使用SIMD批量跳过整块的空白字符，剩余部分逐字节处理
+  if (span_function_ != nullptr &&
+      input_end - character_now >= kMinSpanLength &&
+      std::isspace(static_cast<unsigned char>(character_now[0])) &&
+      std::isspace(static_cast<unsigned char>(character_now[1]))) {
+    character_now += span_function_(character_now, input_end,
+                                    simd_scanner::GetWhiteSpaceRanges());
+  }
+  while (character_now != input_end &&
+         std::isspace(static_cast<unsigned char>(*character_now))) {
+    ++character_now;
+  }
+  // 单词起始位置
+  const char* const word_begin = character_now;
+#ifdef USE_GENERATED_DFA_LEXER
+  // 状态转移和回退已直接编码到生成的函数中
+  StateIndex state_now;
+  character_now =
+      generated_dfa_lexer::MatchWord(character_now, input_end, &state_now);
+  const WordAttachedData* word_attached_data =
+      state_now == DfaConfigType::kInvalidStateIndex
+          ? nullptr
+          : &dfa_config_.word_attached_data[state_now];
+#elif defined(USE_LAZY_DFA)
+  // 状态和转移在第一次到达时构建，构建时可能清空缓存，因此不记录状态编号，
+  // 只记录接受状态对应的单词附属数据（指向配置，清空缓存后仍然有效）
+  LazyDfa& lazy_dfa = match_cache;
+  LazyDfa::StateIndex state_now = lazy_dfa.GetRootState();
+  const WordAttachedData* word_attached_data = nullptr;
+  const char* last_accepted_end = word_begin;
+  while (character_now != input_end) {
+    state_now = lazy_dfa.Transform(state_now, *character_now);
+    if (state_now == LazyDfa::kDeadState) {
+      // 无法移入当前字符
+      break;
+    }
+    ++character_now;
+    const WordAttachedData* state_word_attached_data =
+        lazy_dfa.GetWordAttachedData(state_now);
+    if (state_word_attached_data != nullptr) {
+      word_attached_data = state_word_attached_data;
+      last_accepted_end = character_now;
     }
-    SetCharacterNow(fgetc(file_));
-    SetColumn(GetColumn() + 1);
   }
-  while (true) {
-    // 判断特殊情况
-    switch (GetCharacterNow()) {
-      case EOF:
-        if (feof(file_)) {
-          if (!symbol.empty()) {
-            // 如果已经获取到了单词则返回单词携带的数据而不是直接返回文件尾数据
-            return WordInfo(dfa_config_[transform_array_id].second,
-                            std::move(symbol));
-          } else {
-            // 没有获取到单词，直接返回文件尾数据
-            return WordInfo(GetEndOfFileSavedData(), std::string());
-          }
-        }
+  // 与完整的DFA相同回退到最后一个接受状态
+  character_now = last_accepted_end;
+#else
+  // 当前状态
+  StateIndex state_now =
+      static_cast<StateIndex>(root_transform_array_id_.GetRawValue());
+  // 最长匹配：记录最后一次到达的接受状态和此时单词的尾后字符
+  // 整个输入都在内存中，回退只需要移动指针，不需要重新读取输入
+  StateIndex last_accepted_state = DfaConfigType::kInvalidStateIndex;
+  const char* last_accepted_end = word_begin;
+  while (character_now != input_end) {
+    StateIndex next_state = dfa_config_.Transform(state_now, *character_now);
+    if (next_state == DfaConfigType::kInvalidStateIndex) {
+      // 无法移入当前字符
+      break;
+    }
+    // 可以移入
+    ++character_now;
+    // 进入了新状态且下一个字符仍转移到该状态时批量移入自循环的字符
+    // 只有一个字符的自循环不值得调用SIMD函数
+    if (next_state != state_now && span_function_ != nullptr &&
+        input_end - character_now >= kMinSpanLength &&
+        dfa_config_.Transform(next_state, character_now[0]) == next_state &&
+        dfa_config_.Transform(next_state, character_now[1]) == next_state) {
+      const ByteRanges& self_loop_ranges =
+          dfa_config_.self_loop_ranges[next_state];
+      if (self_loop_ranges.range_num != 0) {
+        character_now +=
+            span_function_(character_now, input_end, self_loop_ranges);
+      }
+    }
+    state_now = next_state;
+    if (accepting_states_[state_now]) {
+      last_accepted_state = state_now;
+      last_accepted_end = character_now;
+    }
+  }
+  // 无法移入字符或达到文件尾，停止时不在接受状态则回退到最后一个接受状态
+  // 从未到达接受状态时回退到单词起始位置，调用方将其视为无法识别
+  character_now = last_accepted_end;
+  const WordAttachedData* word_attached_data =
+      last_accepted_state == DfaConfigType::kInvalidStateIndex
+          ? nullptr
+          : &dfa_config_.word_attached_data[last_accepted_state];
+#endif  // USE_GENERATED_DFA_LEXER
+  return MatchedWord{.word_begin = word_begin,
+                     .word_end = character_now,
+                     .word_attached_data = word_attached_data};
+}
+
+DfaParser::WordInfo DfaParser::GetNextWord() {
+  MatchedWord matched_word = MatchNextWord();
+  // 每个单词只记录一次位置，需要时再计算行数和列数
+  SetOffset(GetCharacterNowOffset());
+  if (matched_word.word_begin == input_end_) [[unlikely]] {
+    // 没有获取到单词，直接返回文件尾数据
+    return WordInfo(GetEndOfFileSavedData(), std::string_view());
+  }
+  if (matched_word.word_begin == character_now_) [[unlikely]] {
+    ReportGrammarError();
+  }
+  std::string_view symbol(matched_word.word_begin,
+                          character_now_ - matched_word.word_begin);
+  LOG_INFO("DFA Parser", std::format("Parsed Word \"{:}\"", symbol))
+  return WordInfo(*matched_word.word_attached_data, symbol);
+}
+
+size_t DfaParser::LexBatch(TokenBuffer& token_buffer, size_t max_tokens) {
+  token_buffer.Clear();
+  token_buffer.Reserve(max_tokens);
+  while (token_buffer.Size() < max_tokens) {
+    MatchedWord matched_word = MatchNextWord();
+    if (matched_word.word_begin == input_end_) [[unlikely]] {
+      // 达到文件尾，添加文件尾单词后结束本批
+      token_buffer.PushBack(GetEndOfFileSavedData().production_node_id,
+                            GetCharacterNowOffset(), 0);
+      break;
+    }
+    if (matched_word.word_begin == character_now_) [[unlikely]] {
+      if (token_buffer.Size() != 0) {
+        // 推迟报错，先让调用方处理本批中错误位置之前的单词
+        // 下次调用时第一个单词即出错
         break;
-      case '\n':
-        // 行数+1
-        SetLine(GetLine() + 1);
-        // 重置列数为0
-        SetColumn(0);
-        SetCharacterNow(fgetc(file_));
-        continue;
+      }
+      ReportGrammarError();
+    }
+    token_buffer.PushBack(
+        matched_word.word_attached_data->production_node_id,
+        matched_word.word_begin - input_begin_,
+        character_now_ - matched_word.word_begin);
+  }
+  return token_buffer.Size();
+}
+
+size_t DfaParser::LexParallel(TokenBuffer& token_buffer, size_t thread_num) {
+  token_buffer.Clear();
+  // 切分剩余输入，每块的结尾移动到换行符后，减少推测起点落在单词中间的情况
+  const size_t remain_size = input_end_ - character_now_;
+  const size_t chunk_num = std::max(
+      size_t(1), std::min(thread_num, remain_size / kMinParallelChunkSize));
+  std::vector<const char*> chunk_begins(1, character_now_);
+  std::vector<LexedChunk> chunks(chunk_num);
+  for (size_t i = 1; i < chunk_num; i++) {
+    const char* chunk_end = std::max(
+        chunk_begins.back(), character_now_ + remain_size / chunk_num * i);
+    const void* newline =
+        std::memchr(chunk_end, '\n', input_end_ - chunk_end);
+    chunk_end = newline == nullptr ? input_end_
+                                   : static_cast<const char*>(newline) + 1;
+    chunks[i - 1].chunk_end = chunk_end;
+    chunk_begins.push_back(chunk_end);
+  }
+  chunks.back().chunk_end = input_end_;
+  // 调用线程解析第一块，其余块交给工作线程
+  std::vector<std::thread> workers;
+  workers.reserve(chunk_num - 1);
+  for (size_t i = 1; i < chunk_num; i++) {
+    workers.emplace_back([this, &chunk_begins, &chunks, i]() {
+      LexChunk(chunk_begins[i], chunks[i]);
+    });
+  }
+  LexChunk(chunk_begins.front(), chunks.front());
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  // 拼接各块
+  token_buffer = std::move(chunks.front().tokens);
+  const char* character_now = chunks.front().resume_position;
+  for (size_t i = 1; i < chunk_num; i++) {
+    const LexedChunk& chunk = chunks[i];
+    // 第一个起始位置不小于当前单词起始位置的推测单词的下标
+    size_t sync_index = 0;
+    while (true) {
+      MatchedWord matched_word = MatchWord(character_now, match_cache_);
+      if (matched_word.word_begin == matched_word.word_end ||
+          matched_word.word_begin >= chunk.chunk_end) {
+        // 达到文件尾、无法识别或整块都推测错误，交给下一块或最后统一处理
         break;
-      default:
+      }
+      const size_t word_offset = matched_word.word_begin - input_begin_;
+      while (sync_index < chunk.tokens.Size() &&
+             chunk.tokens.offsets[sync_index] < word_offset) {
+        ++sync_index;
+      }
+      if (sync_index < chunk.tokens.Size() &&
+          chunk.tokens.offsets[sync_index] == word_offset) [[likely]] {
+        // 从同一位置开始解析的结果相同，之后直接使用推测解析的单词
+        token_buffer.Append(chunk.tokens, sync_index);
+        character_now = chunk.resume_position;
         break;
+      }
+      token_buffer.PushBack(
+          matched_word.word_attached_data->production_node_id,
+          word_offset, matched_word.word_end - matched_word.word_begin);
+      character_now = matched_word.word_end;
     }
-    TransformArrayId next_array_id =
-        dfa_config_[transform_array_id].first[GetCharacterNow()];
-    if (!next_array_id.IsValid()) {
-      // 无法移入当前字符
+  }
+  // 最后一块之后只剩文件尾或无法识别的字符
+  character_now_ = character_now;
+  MatchedWord matched_word = MatchNextWord();
+  assert(matched_word.word_begin == matched_word.word_end);
+  if (matched_word.word_begin == input_end_) [[likely]] {
+    token_buffer.PushBack(GetEndOfFileSavedData().production_node_id,
+                          GetCharacterNowOffset(), 0);
+  } else if (token_buffer.Size() == 0) {
+    ReportGrammarError();
+  }
+  // 否则与LexBatch相同，推迟到下次调用时报错
+  return token_buffer.Size();
+}
+
+void DfaParser::LexChunk(const char* chunk_begin, LexedChunk& chunk) const {
+  const char* character_now = chunk_begin;
+  // 调用线程解析第一块时使用match_cache_以外的缓存，与工作线程相同
+  MatchCache match_cache = CreateMatchCache();
+  while (true) {
+    MatchedWord matched_word = MatchWord(character_now, match_cache);
+    if (matched_word.word_begin == matched_word.word_end ||
+        matched_word.word_begin >= chunk.chunk_end) {
+      // 达到文件尾、无法识别或单词属于下一块
       break;
-    } else {
-      // 可以移入
-      symbol += GetCharacterNow();
-      transform_array_id = next_array_id;
-      SetCharacterNow(fgetc(file_));
-      SetColumn(GetColumn() + 1);
     }
+    chunk.tokens.PushBack(
+        matched_word.word_attached_data->production_node_id,
+        matched_word.word_begin - input_begin_,
+        matched_word.word_end - matched_word.word_begin);
+    character_now = matched_word.word_end;
   }
+  chunk.resume_position = character_now;
+}
 
-  if (symbol.empty()) {
-    LOG_ERROR("DFA Parser", std::format("Line: {:} Column: {:}: Grammar Error!", GetLine() + 1, GetColumn() + 1))
-    exit(-1);
+void DfaParser::ReportGrammarError() const {
+  SetOffset(GetCharacterNowOffset());
+  LOG_ERROR("DFA Parser",
+            std::format("Line: {:} Column: {:} Offset: {:}: Grammar Error!",
+                        GetLine() + 1, GetColumn() + 1,
+                        GetCharacterNowOffset()))
+  exit(-1);
+}
+
+void DfaParser::WordAttachedDataTableConstruct() {
+  word_attached_data_table_.clear();
+  auto add_word_attached_data =
+      [this](const WordAttachedData& word_attached_data) {
+        if (!word_attached_data.production_node_id.IsValid()) {
+          // 非接受状态没有对应的单词
+          return;
+        }
+        size_t index = word_attached_data.production_node_id.GetRawValue();
+        if (index >= word_attached_data_table_.size()) {
+          word_attached_data_table_.resize(index + 1);
+        }
+        word_attached_data_table_[index] = word_attached_data;
+      };
+#ifdef USE_LAZY_DFA
+  // DFA状态按需构建，所有单词都是某个闭包代表的单词
+  for (const auto& word_attached_data :
+       lazy_dfa_config_.closure_word_attached_data) {
+    add_word_attached_data(word_attached_data);
   }
-  LOG_INFO("DFA Parser", std::format("Parsed Word \"{:}\"", symbol))
-  return WordInfo(dfa_config_[transform_array_id].second, std::move(symbol));
+#else
+  accepting_states_.clear();
+  accepting_states_.reserve(dfa_config_.word_attached_data.size());
+  for (const auto& word_attached_data : dfa_config_.word_attached_data) {
+    add_word_attached_data(word_attached_data);
+    accepting_states_.push_back(
+        word_attached_data.production_node_id.IsValid());
+  }
+#endif  // USE_LAZY_DFA
+  add_word_attached_data(file_end_saved_data_);
 }
 
 }  // namespace frontend::parser::dfa_parser
\ No newline at end of file
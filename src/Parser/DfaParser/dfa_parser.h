@@ -6,9 +6,16 @@
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <string_view>
 
 #include "Common/common.h"
 #include "Generator/export_types.h"
+#ifdef USE_GENERATED_DFA_LEXER
+#include "Parser/DfaParser/generated_dfa_lexer.h"
+#endif  // USE_GENERATED_DFA_LEXER
+#include "Parser/DfaParser/input_file.h"
+#include "Parser/DfaParser/lazy_dfa.h"
+#include "Parser/DfaParser/simd_scanner.h"
 #include "Parser/line_and_column.h"
 #include "boost/archive/binary_iarchive.hpp"
 
@@ -18,17 +25,17 @@ namespace frontend::parser::dfa_parser {
 /// @brief DFA解析器
 class DfaParser {
   using DfaConfigType = frontend::generator::dfa_generator::DfaConfigType;
+  using LazyDfaConfig = frontend::generator::dfa_generator::LazyDfaConfig;
   using WordAttachedData = frontend::generator::dfa_generator::WordAttachedData;
   using TransformArrayId = frontend::generator::dfa_generator::TransformArrayId;
+  using StateIndex = DfaConfigType::StateIndex;
+  using ByteRanges = frontend::generator::dfa_generator::ByteRanges;
+  using ProductionNodeId =
+      frontend::generator::syntax_generator::ProductionNodeId;
 
  public:
   DfaParser() {}
   DfaParser(const DfaParser&) = delete;
-  ~DfaParser() {
-    if (file_ != nullptr) {
-      fclose(file_);
-    }
-  }
   DfaParser& operator=(const DfaParser&) = delete;
 
   /// @class WordInfo dfa_parser.h
@@ -36,21 +43,76 @@ class DfaParser {
   struct WordInfo {
     WordInfo() = default;
     template <class SavedDataType>
-    WordInfo(SavedDataType&& saved_data, std::string&& symbol_)
+    WordInfo(SavedDataType&& saved_data, std::string_view symbol)
         : word_attached_data_(std::forward<SavedDataType>(saved_data)),
-          symbol_(std::move(symbol_)) {}
+          symbol_(symbol) {}
     WordInfo(WordInfo&& return_data)
         : word_attached_data_(std::move(return_data.word_attached_data_)),
-          symbol_(std::move(return_data.symbol_)) {}
+          symbol_(return_data.symbol_) {}
     WordInfo& operator=(WordInfo&& return_data) {
       word_attached_data_ = std::move(return_data.word_attached_data_);
-      symbol_ = std::move(return_data.symbol_);
+      symbol_ = return_data.symbol_;
       return *this;
     }
     /// @brief 单词的附属数据（添加单词时存储）
     WordAttachedData word_attached_data_;
     /// @brief 获取到的单词
-    std::string symbol_;
+    /// @attention 直接引用输入文件/缓冲区的内容，重新设置输入或Reset后失效
+    std::string_view symbol_;
+  };
+
+  /// @class TokenBuffer dfa_parser.h
+  /// @brief 批量获取的单词，按列存储（struct of arrays）
+  /// @details 第i个单词的各项数据存储在各数组的第i个元素中
+  struct TokenBuffer {
+    /// @brief 清空单词，保留已分配的内存
+    void Clear() {
+      production_node_ids.clear();
+      offsets.clear();
+      lengths.clear();
+    }
+    /// @brief 预分配内存
+    /// @param[in] token_num ：预分配的单词数目
+    void Reserve(size_t token_num) {
+      production_node_ids.reserve(token_num);
+      offsets.reserve(token_num);
+      lengths.reserve(token_num);
+    }
+    /// @brief 添加单词
+    /// @param[in] production_node_id ：单词对应的产生式节点ID
+    /// @param[in] offset ：单词相对输入开头的偏移
+    /// @param[in] length ：单词长度
+    void PushBack(ProductionNodeId production_node_id, size_t offset,
+                  size_t length) {
+      production_node_ids.push_back(production_node_id);
+      offsets.push_back(offset);
+      lengths.push_back(length);
+    }
+    /// @brief 获取单词数目
+    /// @return 返回单词数目
+    size_t Size() const { return production_node_ids.size(); }
+    /// @brief 添加另一组单词中从给定下标开始的所有单词
+    /// @param[in] token_buffer ：待添加的单词
+    /// @param[in] first_index ：第一个待添加的单词的下标
+    void Append(const TokenBuffer& token_buffer, size_t first_index) {
+      production_node_ids.insert(
+          production_node_ids.end(),
+          token_buffer.production_node_ids.begin() + first_index,
+          token_buffer.production_node_ids.end());
+      offsets.insert(offsets.end(), token_buffer.offsets.begin() + first_index,
+                     token_buffer.offsets.end());
+      lengths.insert(lengths.end(), token_buffer.lengths.begin() + first_index,
+                     token_buffer.lengths.end());
+    }
+
+    /// @brief 单词对应的产生式节点ID
+    /// @note 使用DfaParser::GetWordAttachedData获取单词的附属数据
+    std::vector<ProductionNodeId> production_node_ids;
+    /// @brief 单词相对输入开头的偏移
+    std::vector<size_t> offsets;
+    /// @brief 单词长度
+    /// @note 行数和列数由frontend::parser::GetLine/GetColumn根据偏移按需计算
+    std::vector<size_t> lengths;
   };
 
   /// @brief 设置输入文件
@@ -58,22 +120,81 @@ class DfaParser {
   /// @return 返回打开文件是否成功
   /// @retval true 成功打开文件
   /// @retval false 打开文件失败
-  /// @note 自动读取输入文件的第一个字符到character_now
+  /// @note 优先将文件映射到内存，无法映射时一次性读取全部内容
+  /// 自动将character_now_指向输入文件的第一个字符并重置行数和列数
   bool SetInputFile(const std::string filename);
+  /// @brief 设置输入缓冲区
+  /// @param[in] input_buffer ：待解析的内容
+  /// @note 直接在给定缓冲区上解析，不复制内容也不访问文件系统
+  /// 自动将character_now_指向缓冲区的第一个字符并重置行数和列数
+  /// @attention 解析完成前调用方必须保证缓冲区有效
+  void SetInputBuffer(std::string_view input_buffer);
   /// @brief 获取下一个单词
   /// @return 返回获取到的单词数据
-  /// @retval WordInfo(GetEndOfFileSavedData,std::string())
+  /// @retval WordInfo(GetEndOfFileSavedData,std::string_view())
   /// 达到文件尾且未获取到单词
   /// @note
   /// 如果获取单词时达到文件尾则返回获取到的单词和附属数据
+  /// 返回的单词直接引用输入文件的内容，不复制字符
   WordInfo GetNextWord();
 
+  /// @brief 批量获取单词
+  /// @param[out] token_buffer ：存储获取到的单词，调用时自动清空
+  /// @param[in] max_tokens ：最多获取的单词数目
+  /// @return 返回获取到的单词数目
+  /// @details
+  /// 1.达到文件尾时添加一个文件尾单词（长度为0）并结束本批
+  /// 2.遇到无法识别的字符时结束本批，下一次调用时报错，以便调用方先处理
+  /// 出错位置之前的单词
+  /// @note 单词内容可以通过GetInputContent和偏移、长度获取
+  size_t LexBatch(TokenBuffer& token_buffer, size_t max_tokens);
+  /// @brief 多线程获取剩余输入中的所有单词
+  /// @param[out] token_buffer ：存储获取到的单词，调用时自动清空
+  /// @param[in] thread_num ：最多使用的线程数（包括调用线程）
+  /// @return 返回获取到的单词数目
+  /// @details
+  /// 1.将剩余输入在换行符后切分为若干块，每块不小于kMinParallelChunkSize，
+  /// 每个线程从DFA起始状态推测解析一块
+  /// 2.所有线程结束后按顺序拼接各块：从上一块解析结束的位置顺序解析，
+  /// 直到某个单词的起始位置与下一块推测解析得到的某个单词相同，
+  /// 之后两者得到的单词完全相同，直接使用推测解析的结果
+  /// 推测起点错误的块（如从字符串中间开始）在拼接时重新解析，
+  /// 因此结果与顺序调用LexBatch得到的单词完全相同
+  /// 3.文件尾和无法识别的字符的处理方式与LexBatch相同
+  /// @note 适用于数百MB的单个输入，较小的输入只使用调用线程
+  size_t LexParallel(TokenBuffer& token_buffer, size_t thread_num);
+  /// @brief 获取单词的附属数据
+  /// @param[in] production_node_id ：单词对应的产生式节点ID
+  /// @return 返回单词附属数据的const引用
+  /// @note 无效的ID返回默认构造的附属数据
+  const WordAttachedData& GetWordAttachedData(
+      ProductionNodeId production_node_id) const {
+    if (production_node_id.IsValid() &&
+        production_node_id < word_attached_data_table_.size()) [[likely]] {
+      return word_attached_data_table_[production_node_id];
+    } else {
+      static const WordAttachedData invalid_word_attached_data{};
+      return invalid_word_attached_data;
+    }
+  }
+  /// @brief 获取整个输入的内容
+  /// @return 返回整个输入文件/缓冲区的内容
+  std::string_view GetInputContent() const {
+    return std::string_view(input_begin_, input_end_ - input_begin_);
+  }
+
   /// @brief 重置状态
+  /// @note 关闭输入文件，之前获取的所有单词失效
   void Reset() {
-    file_ = nullptr;
-    SetLine(0);
-    SetColumn(0);
+    input_file_.Close();
+    input_begin_ = nullptr;
+    character_now_ = nullptr;
+    input_end_ = nullptr;
+    SetInput(std::string_view());
   }
+  /// @brief 获取当前待处理字符相对输入开头的偏移
+  /// @return 返回当前待处理字符相对输入文件/缓冲区开头的字节偏移
+  size_t GetCharacterNowOffset() const { return character_now_ - input_begin_; }
   /// @brief 设置达到文件尾且未获取到任何单词时返回的单词数据
   /// @param[in] word_attached_data ：单词数据
   void SetEndOfFileSavedData(const WordAttachedData& word_attached_data) {
@@ -86,18 +207,24 @@ class DfaParser {
   }
   /// @brief 加载配置
   /// @note 配置文件名为frontend::common::kDfaConfigFileName
+  /// 使用生成的词法分析器时配置已编译进程序，不读取配置文件
+  /// 定义USE_LAZY_DFA时配置文件中存储压缩编号后的NFA，DFA状态在解析时按需构建
   void LoadConfig() {
+#ifdef USE_GENERATED_DFA_LEXER
+    using generated_dfa_lexer::kStateNum;
+    using generated_dfa_lexer::kWordAttachedData;
+    dfa_config_.word_attached_data.assign(kWordAttachedData,
+                                          kWordAttachedData + kStateNum);
+    file_end_saved_data_ = generated_dfa_lexer::kEndOfFileSavedData;
+    WordAttachedDataTableConstruct();
+    match_cache_ = CreateMatchCache();
+#else
     std::ifstream config_file(frontend::common::kDfaConfigFileName,
                               std::ios_base::binary);
     boost::archive::binary_iarchive iarchive(config_file);
     iarchive >> *this;
+#endif  // USE_GENERATED_DFA_LEXER
   }
-  /// @brief 设置当前待处理字符
-  /// @param[in] character_now ：当前待处理字符
-  void SetCharacterNow(char character_now) { character_now_ = character_now; }
-  /// @brief 获取当前待处理字符
-  /// @return 返回当前待处理字符
-  char GetCharacterNow() const { return character_now_; }
 
  private:
   /// @brief 允许序列化类访问成员
@@ -109,23 +236,127 @@ class DfaParser {
   /// @attention 该函数应由boost库调用而非手动调用
   template <class Archive>
   void load(Archive& ar, const unsigned int version) {
+#ifdef USE_LAZY_DFA
+    ar >> lazy_dfa_config_;
+#else
     ar >> dfa_config_;
     ar >> root_transform_array_id_;
+#endif  // USE_LAZY_DFA
     ar >> file_end_saved_data_;
+    WordAttachedDataTableConstruct();
+    match_cache_ = CreateMatchCache();
   }
   /// 将序列化分为保存与加载，Parser仅加载配置，不保存
   BOOST_SERIALIZATION_SPLIT_MEMBER()
 
+  /// @brief 多线程解析时每块的最小字节数
+  static constexpr size_t kMinParallelChunkSize = 4 * 1024 * 1024;
+
+#ifdef USE_LAZY_DFA
+  /// @brief MatchWord使用的缓存，存储已构建的DFA状态
+  /// @note 缓存不是线程安全的，每个线程使用独立的缓存
+  using MatchCache = LazyDfa;
+#else
+  /// @class MatchCache dfa_parser.h
+  /// @brief 使用完整的DFA时MatchWord不需要缓存
+  struct MatchCache {};
+#endif  // USE_LAZY_DFA
+
+  /// @class MatchedWord dfa_parser.h
+  /// @brief MatchWord的返回值
+  struct MatchedWord {
+    /// @brief 单词起始位置，等于输入尾后字符时代表达到文件尾
+    const char* word_begin;
+    /// @brief 单词尾后字符，与起始位置相同代表无法识别
+    /// @note 按最长匹配原则确定，即最后一次到达接受状态时的位置
+    const char* word_end;
+    /// @brief 单词的附属数据，无法识别时为nullptr
+    const WordAttachedData* word_attached_data;
+  };
+  /// @class LexedChunk dfa_parser.h
+  /// @brief 多线程解析时一块输入的推测解析结果
+  struct LexedChunk {
+    /// @brief 起始位置在该块内的单词
+    TokenBuffer tokens;
+    /// @brief 该块的尾后字符（下一块的起始位置）
+    const char* chunk_end;
+    /// @brief 最后一个单词的尾后字符，从这里继续解析得到下一块的单词
+    const char* resume_position;
+  };
+
+  /// @brief 从给定位置跳过空白字符并获取下一个单词的位置和附属数据
+  /// @param[in] character_now ：开始解析的位置
+  /// @param[in,out] match_cache ：当前线程使用的缓存
+  /// @return 返回单词的起始位置、尾后字符和单词的附属数据
+  /// @details
+  /// 转移到无法移入字符或达到文件尾为止，如果此时不在接受状态则回退到
+  /// 最后一次到达接受状态的位置（最长匹配）
+  /// @note 不修改成员，不同线程使用不同的match_cache时可以同时调用
+  MatchedWord MatchWord(const char* character_now,
+                        MatchCache& match_cache) const;
+  /// @brief 从character_now_开始获取下一个单词的位置和附属数据
+  /// @return 返回单词的起始位置、尾后字符和单词的附属数据
+  /// @note 将character_now_移动到单词结尾，GetNextWord和LexBatch的共用部分
+  MatchedWord MatchNextWord() {
+    MatchedWord matched_word = MatchWord(character_now_, match_cache_);
+    character_now_ = matched_word.word_end;
+    return matched_word;
+  }
+  /// @brief 推测解析一块输入
+  /// @param[in] chunk_begin ：该块的起始位置
+  /// @param[in,out] chunk ：需要预先设置chunk_end，返回解析结果
+  /// @details 解析所有起始位置在块内的单词，遇到文件尾或无法识别的字符时停止
+  /// @note 不修改成员，由工作线程调用
+  void LexChunk(const char* chunk_begin, LexedChunk& chunk) const;
+  /// @brief 输出无法识别当前字符的错误信息并退出
+  [[noreturn]] void ReportGrammarError() const;
+  /// @brief 构建产生式节点ID到单词附属数据的映射表并标记DFA接受状态
+  /// @note 加载配置后调用
+  void WordAttachedDataTableConstruct();
+  /// @brief 创建MatchWord使用的缓存
+  /// @return 返回空缓存
+  /// @note 加载配置后调用
+  MatchCache CreateMatchCache() const {
+#ifdef USE_LAZY_DFA
+    MatchCache match_cache;
+    match_cache.LazyDfaInit(lazy_dfa_config_);
+    return match_cache;
+#else
+    return MatchCache();
+#endif  // USE_LAZY_DFA
+  }
+
   /// @brief 起始DFA分析表ID
   TransformArrayId root_transform_array_id_;
   /// @brief DFA配置
   DfaConfigType dfa_config_;
+#ifdef USE_LAZY_DFA
+  /// @brief 压缩编号后的NFA，代替dfa_config_和root_transform_array_id_
+  LazyDfaConfig lazy_dfa_config_;
+#endif  // USE_LAZY_DFA
+  /// @brief 调用线程使用的MatchWord缓存
+  /// @note 工作线程使用各自创建的缓存
+  MatchCache match_cache_;
   /// @brief 遇到文件尾且未获取到单词时返回的数据
   WordAttachedData file_end_saved_data_;
+  /// @brief 产生式节点ID到单词附属数据的映射表，下标为产生式节点ID
+  /// @note 加载配置时构建，同一个产生式节点ID的附属数据唯一
+  std::vector<WordAttachedData> word_attached_data_table_;
+  /// @brief 每个DFA状态是否为接受状态，下标为状态
+  /// @note 比访问dfa_config_.word_attached_data更紧凑，逐字节转移时使用
+  std::vector<uint8_t> accepting_states_;
   /// @brief 当前输入文件
-  FILE* file_ = nullptr;
-  /// @brief 当前待处理字符
-  char character_now_;
+  /// @note 使用SetInputBuffer设置输入时不打开文件
+  InputFile input_file_;
+  /// @brief 指向输入内容的第一个字符
+  const char* input_begin_ = nullptr;
+  /// @brief 指向当前待处理字符
+  const char* character_now_ = nullptr;
+  /// @brief 指向输入内容尾后字符
+  const char* input_end_ = nullptr;
+  /// @brief 当前CPU支持的SIMD扫描函数，不支持SIMD时为nullptr
+  const simd_scanner::SpanFunction span_function_ =
+      simd_scanner::GetSpanFunction();
 };
 
 }  // namespace frontend::parser::dfa_parser
@@ -0,0 +1,37 @@
+﻿/// @file generated_dfa_lexer.h
+/// @brief DfaGenerator生成的直接编码词法分析器的接口
+/// @details
+/// DfaGenerator::SaveLexerSource将DFA转移表输出为C++源文件，每个状态对应一个
+/// 标签，状态转移编译为switch和goto，不再查表
+/// 定义USE_GENERATED_DFA_LEXER时DfaParser使用该接口代替DFA转移表，
+/// 实现由生成的源文件提供（构建时通过GENERATED_DFA_LEXER_SOURCE指定）
+#ifndef PARSER_DFAPARSER_GENERATEDDFALEXER_H_
+#define PARSER_DFAPARSER_GENERATEDDFALEXER_H_
+
+#include "Generator/export_types.h"
+
+namespace frontend::parser::dfa_parser::generated_dfa_lexer {
+
+using frontend::generator::dfa_generator::DfaConfigType;
+using frontend::generator::dfa_generator::WordAttachedData;
+using StateIndex = DfaConfigType::StateIndex;
+
+/// @brief 从给定位置开始匹配单词
+/// @param[in] character_now ：单词的第一个字符
+/// @param[in] input_end ：输入尾后字符
+/// @param[out] state ：返回单词对应的接受状态，无法识别时返回kInvalidStateIndex
+/// @return 返回单词的尾后字符，无法识别时返回character_now
+/// @details 按最长匹配原则，停止转移时不在接受状态则回退到最后一个接受状态
+/// @note 与使用DFA转移表时DfaParser的逐字节转移等价，不跳过空白字符
+const char* MatchWord(const char* character_now, const char* input_end,
+                      StateIndex* state);
+/// @brief DFA状态数目
+extern const size_t kStateNum;
+/// @brief 每个DFA状态对应的单词附属数据，下标为状态
+/// @note 非接受状态的产生式节点ID无效
+extern const WordAttachedData kWordAttachedData[];
+/// @brief 遇到文件尾且未获取到单词时返回的数据
+extern const WordAttachedData kEndOfFileSavedData;
+
+}  // namespace frontend::parser::dfa_parser::generated_dfa_lexer
+#endif  /// !PARSER_DFAPARSER_GENERATEDDFALEXER_H_
@@ -0,0 +1,142 @@
+﻿#include "Parser/DfaParser/input_file.h"
+
+#include <cerrno>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif  // !NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace frontend::parser::dfa_parser {
+
+bool InputFile::Open(const std::string& filename) {
+  Close();
+  // 文件只打开一次，无法映射时从同一个句柄读取
+  // 管道等输入重新打开会丢失数据或阻塞，文件也可能在两次打开之间被修改
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+#else
+  int file = open(filename.c_str(), O_RDONLY);
+  if (file == -1) {
+    return false;
+  }
+#endif  // _WIN32
+  bool result = MapFile(file) || ReadWholeFile(file);
+#ifdef _WIN32
+  CloseHandle(file);
+#else
+  // 映射存在期间不需要保留文件描述符
+  close(file);
+#endif  // _WIN32
+  return result;
+}
+
+void InputFile::Close() {
+  if (mapped_data_ != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapped_data_);
+#else
+    munmap(const_cast<char*>(mapped_data_), mapped_size_);
+#endif  // _WIN32
+    mapped_data_ = nullptr;
+    mapped_size_ = 0;
+  }
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+}
+
+bool InputFile::MapFile(FileHandle file) {
+#ifdef _WIN32
+  LARGE_INTEGER file_size;
+  // 空文件无法创建映射，管道等非磁盘文件不能映射
+  if (GetFileType(file) != FILE_TYPE_DISK ||
+      !GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return false;
+  }
+  // 视图存在期间映射对象不会被释放，可以直接关闭句柄
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    return false;
+  }
+  mapped_data_ = static_cast<const char*>(view);
+  mapped_size_ = static_cast<size_t>(file_size.QuadPart);
+  return true;
+#else
+  struct stat file_stat;
+  // 空文件无法创建映射，管道等非普通文件不能映射
+  if (fstat(file, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+      file_stat.st_size <= 0) {
+    return false;
+  }
+  size_t file_size = static_cast<size_t>(file_stat.st_size);
+  void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  // DFA解析器顺序读取输入，提示内核积极预读
+  madvise(view, file_size, MADV_SEQUENTIAL);
+  mapped_data_ = static_cast<const char*>(view);
+  mapped_size_ = file_size;
+  return true;
+#endif  // _WIN32
+}
+
+bool InputFile::ReadWholeFile(FileHandle file) {
+  // 管道等输入无法预知大小，分块读取直到文件尾
+  constexpr size_t kReadBlockSize = 64 * 1024;
+  size_t size_read = 0;
+  bool result = true;
+  while (true) {
+    buffer_.resize(size_read + kReadBlockSize);
+#ifdef _WIN32
+    DWORD block_size_read;
+    if (!ReadFile(file, buffer_.data() + size_read, kReadBlockSize,
+                  &block_size_read, nullptr)) {
+      // 管道写端关闭视为到达文件尾
+      result = GetLastError() == ERROR_BROKEN_PIPE;
+      break;
+    }
+#else
+    ssize_t block_size_read =
+        read(file, buffer_.data() + size_read, kReadBlockSize);
+    if (block_size_read == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      result = false;
+      break;
+    }
+#endif  // _WIN32
+    if (block_size_read == 0) {
+      // 到达文件尾
+      break;
+    }
+    size_read += static_cast<size_t>(block_size_read);
+  }
+  buffer_.resize(size_read);
+  if (!result) [[unlikely]] {
+    buffer_.clear();
+  }
+  return result;
+}
+
+}  // namespace frontend::parser::dfa_parser
@@ -0,0 +1,76 @@
+﻿/// @file input_file.h
+/// @brief DFA解析器使用的输入文件
+/// @details
+/// 优先将整个输入文件映射到内存，DFA解析器直接在映射的内存上逐字节转移，
+/// 获取到的单词以std::string_view形式直接引用映射的内存，不再逐字符复制
+/// 无法映射的文件（管道、空文件等）退化为一次性读取全部内容到缓冲区
+#ifndef PARSER_DFAPARSER_INPUTFILE_H_
+#define PARSER_DFAPARSER_INPUTFILE_H_
+
+#include <string>
+#include <string_view>
+
+namespace frontend::parser::dfa_parser {
+
+/// @class InputFile input_file.h
+/// @brief 只读输入文件，持有文件全部内容直到关闭
+/// @note 所有通过GetContent获取的std::string_view在Close/再次Open后失效
+class InputFile {
+ public:
+  InputFile() = default;
+  InputFile(const InputFile&) = delete;
+  ~InputFile() { Close(); }
+  InputFile& operator=(const InputFile&) = delete;
+
+  /// @brief 打开输入文件
+  /// @param[in] filename ：输入文件名
+  /// @return 返回打开文件是否成功
+  /// @retval true 成功打开文件
+  /// @retval false 打开文件失败
+  /// @note 自动关闭之前打开的文件；优先使用内存映射，失败则读取到缓冲区
+  bool Open(const std::string& filename);
+  /// @brief 关闭文件并释放映射的内存或缓冲区
+  void Close();
+  /// @brief 获取文件全部内容
+  /// @return 返回指向文件全部内容的std::string_view
+  std::string_view GetContent() const {
+    if (mapped_data_ != nullptr) {
+      return std::string_view(mapped_data_, mapped_size_);
+    } else {
+      return std::string_view(buffer_);
+    }
+  }
+  /// @brief 判断文件内容是否通过内存映射获得
+  /// @return 返回文件内容是否通过内存映射获得
+  bool IsMapped() const { return mapped_data_ != nullptr; }
+
+ private:
+#ifdef _WIN32
+  /// @brief 已打开的文件句柄，与Windows的HANDLE相同
+  using FileHandle = void*;
+#else
+  /// @brief 已打开的文件描述符
+  using FileHandle = int;
+#endif  // _WIN32
+
+  /// @brief 将已打开的文件映射到内存
+  /// @param[in] file ：已打开的文件
+  /// @return 返回是否映射成功
+  /// @note 不是普通文件或文件为空时返回false，不关闭file
+  bool MapFile(FileHandle file);
+  /// @brief 从已打开的文件读取全部内容到buffer_
+  /// @param[in] file ：已打开的文件
+  /// @return 返回是否读取成功
+  /// @note 用于无法映射的输入（如管道），读取到文件尾为止，不关闭file
+  bool ReadWholeFile(FileHandle file);
+
+  /// @brief 映射的内存首地址，未映射时为nullptr
+  const char* mapped_data_ = nullptr;
+  /// @brief 映射的内存大小
+  size_t mapped_size_ = 0;
+  /// @brief 无法映射时存储文件内容的缓冲区
+  std::string buffer_;
+};
+
+}  // namespace frontend::parser::dfa_parser
+#endif  /// !PARSER_DFAPARSER_INPUTFILE_H_
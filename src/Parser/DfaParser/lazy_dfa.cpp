@@ -0,0 +1,143 @@
+﻿#include "Parser/DfaParser/lazy_dfa.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace frontend::parser::dfa_parser {
+
+size_t LazyDfa::StateMembersHasher::operator()(
+    const std::vector<uint32_t>& members) const {
+  uint64_t hash = 0x9E3779B97F4A7C15ull ^ members.size();
+  for (uint32_t member : members) {
+    hash = (hash ^ member) * 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 31;
+  }
+  return static_cast<size_t>(hash);
+}
+
+void LazyDfa::LazyDfaInit(const LazyDfaConfig& lazy_dfa_config,
+                          size_t max_cache_size) {
+  lazy_dfa_config_ = &lazy_dfa_config;
+  max_cache_size_ = max_cache_size;
+  flush_times_ = 0;
+  class_first_byte_.assign(lazy_dfa_config.class_num, 0);
+  // 倒序遍历使每个等价类记录最小的字节
+  for (size_t c = frontend::common::kCharNum; c-- > 0;) {
+    class_first_byte_[lazy_dfa_config.char_to_class[c]] =
+        static_cast<uint8_t>(c);
+  }
+  node_marks_.assign(lazy_dfa_config.GetNodeNum(), 0);
+  mark_generation_ = 0;
+  FlushCache();
+  flush_times_ = 0;
+}
+
+void LazyDfa::RootStateConstruct() {
+  const LazyDfaConfig& config = *lazy_dfa_config_;
+  const uint32_t root_closure = config.root_closure;
+  next_members_.assign(
+      config.closure_members.begin() +
+          config.closure_member_offsets[root_closure],
+      config.closure_members.begin() +
+          config.closure_member_offsets[root_closure + 1]);
+  std::sort(next_members_.begin(), next_members_.end());
+  // 添加初始状态可能清空缓存，因此在添加后再填写root_state_
+  StateIndex root_state = FindOrInsertState(kNoWordClosure);
+  root_state_ = root_state;
+}
+
+LazyDfa::StateIndex LazyDfa::TransformConstruct(StateIndex state,
+                                                uint8_t byte_class) {
+  const LazyDfaConfig& config = *lazy_dfa_config_;
+  const uint8_t byte = class_first_byte_[byte_class];
+  if (++mark_generation_ == 0) [[unlikely]] {
+    // 标记回绕，清除所有旧标记
+    std::fill(node_marks_.begin(), node_marks_.end(), 0);
+    mark_generation_ = 1;
+  }
+  // 与子集构造相同：按节点编号和条件转移的顺序合并闭包，
+  // 优先级相同时选择第一个遇到的单词
+  next_members_.clear();
+  size_t word_closure = kNoWordClosure;
+  for (uint32_t member : *state_members_[state]) {
+    for (uint32_t i = config.transfer_offsets[member];
+         i < config.transfer_offsets[member + 1]; i++) {
+      const auto& [low, high, closure_index] = config.transfers[i];
+      if (low > byte) {
+        // 条件转移按low从小到大排列，之后的转移都不包含该字节
+        break;
+      }
+      if (byte > high) {
+        continue;
+      }
+      if (config.IsWordClosure(closure_index)) [[unlikely]] {
+        if (word_closure == kNoWordClosure ||
+            config.closure_word_priority[closure_index] >
+                config.closure_word_priority[word_closure]) {
+          word_closure = closure_index;
+        }
+      }
+      for (uint32_t j = config.closure_member_offsets[closure_index];
+           j < config.closure_member_offsets[closure_index + 1]; j++) {
+        const uint32_t closure_member = config.closure_members[j];
+        if (node_marks_[closure_member] != mark_generation_) {
+          node_marks_[closure_member] = mark_generation_;
+          next_members_.push_back(closure_member);
+        }
+      }
+    }
+  }
+  if (next_members_.empty()) {
+    transitions_[state * config.class_num + byte_class] = kDeadState;
+    return kDeadState;
+  }
+  std::sort(next_members_.begin(), next_members_.end());
+  const size_t flush_times = flush_times_;
+  StateIndex next_state = FindOrInsertState(word_closure);
+  if (flush_times == flush_times_) [[likely]] {
+    // 清空缓存后起点状态已不存在，不记录转移
+    transitions_[state * config.class_num + byte_class] = next_state;
+  }
+  return next_state;
+}
+
+LazyDfa::StateIndex LazyDfa::FindOrInsertState(size_t word_closure) {
+  auto iter = members_to_state_.find(next_members_);
+  if (iter != members_to_state_.end()) {
+    return iter->second;
+  }
+  const size_t class_num = lazy_dfa_config_->class_num;
+  // 节点编号集合、转移表的一行、状态数据和哈希表节点的大小
+  const size_t state_size = next_members_.size() * sizeof(uint32_t) +
+                            class_num * sizeof(StateIndex) +
+                            sizeof(std::vector<uint32_t>) * 2 +
+                            sizeof(void*) * 4;
+  if (cache_size_ + state_size > max_cache_size_ &&
+      !state_word_attached_data_.empty()) [[unlikely]] {
+    FlushCache();
+  }
+  cache_size_ += state_size;
+  const StateIndex state =
+      static_cast<StateIndex>(state_word_attached_data_.size());
+  assert(state < kDeadState);
+  iter = members_to_state_.emplace(next_members_, state).first;
+  state_members_.push_back(&iter->first);
+  state_word_attached_data_.push_back(
+      word_closure == kNoWordClosure
+          ? nullptr
+          : &lazy_dfa_config_->closure_word_attached_data[word_closure]);
+  transitions_.resize(transitions_.size() + class_num, kUnknownState);
+  return state;
+}
+
+void LazyDfa::FlushCache() {
+  members_to_state_.clear();
+  state_members_.clear();
+  state_word_attached_data_.clear();
+  transitions_.clear();
+  cache_size_ = 0;
+  root_state_ = kUnknownState;
+  ++flush_times_;
+}
+
+}  // namespace frontend::parser::dfa_parser
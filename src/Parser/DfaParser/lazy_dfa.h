@@ -0,0 +1,152 @@
+﻿/// @file lazy_dfa.h
+/// @brief 运行时按需构建状态的DFA（惰性DFA）
+/// @details
+/// 1.配置文件中只存储压缩编号后的NFA（LazyDfaConfig），DFA状态在解析时第一次
+/// 到达才通过子集构造计算，转移也在第一次使用时计算并缓存
+/// 2.状态使用排序后的NFA节点编号集合表示，相同集合对应同一个状态
+/// 3.缓存的状态占用的内存超过上限时清空全部缓存，之后从当前位置重新构建，
+/// 因此内存占用有界，解析结果与完整DFA相同
+/// 4.对象不是线程安全的，每个线程使用独立的对象，多个对象可以共享同一个配置
+#ifndef PARSER_DFAPARSER_LAZYDFA_H_
+#define PARSER_DFAPARSER_LAZYDFA_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Generator/export_types.h"
+
+namespace frontend::parser::dfa_parser {
+
+/// @class LazyDfa lazy_dfa.h
+/// @brief 按需构建状态的DFA
+class LazyDfa {
+ public:
+  using LazyDfaConfig = frontend::generator::dfa_generator::LazyDfaConfig;
+  using WordAttachedData = frontend::generator::dfa_generator::WordAttachedData;
+  /// @brief 缓存中的状态编号
+  /// @attention 清空缓存后之前获取的状态编号全部失效
+  using StateIndex = uint32_t;
+
+  /// @brief 表示转移尚未计算的状态编号
+  static constexpr StateIndex kUnknownState = UINT32_MAX;
+  /// @brief 表示无法转移的状态编号
+  static constexpr StateIndex kDeadState = UINT32_MAX - 1;
+  /// @brief 默认的缓存内存上限（字节）
+  static constexpr size_t kDefaultMaxCacheSize = 8 * 1024 * 1024;
+
+  LazyDfa() = default;
+  LazyDfa(const LazyDfa&) = delete;
+  LazyDfa(LazyDfa&&) = default;
+  LazyDfa& operator=(const LazyDfa&) = delete;
+  LazyDfa& operator=(LazyDfa&&) = default;
+
+  /// @brief 初始化
+  /// @param[in] lazy_dfa_config ：压缩编号后的NFA
+  /// @param[in] max_cache_size ：缓存的状态最多占用的内存（字节）
+  /// @note 清空之前缓存的所有状态
+  /// @attention lazy_dfa_config在对象使用期间必须保持有效且不被修改
+  void LazyDfaInit(const LazyDfaConfig& lazy_dfa_config,
+                   size_t max_cache_size = kDefaultMaxCacheSize);
+
+  /// @brief 获取初始状态
+  /// @return 返回初始状态编号
+  /// @note 初始状态不在缓存中时构建初始状态，可能清空缓存
+  StateIndex GetRootState() {
+    if (root_state_ == kUnknownState) [[unlikely]] {
+      RootStateConstruct();
+    }
+    return root_state_;
+  }
+  /// @brief 获取状态在给定字符下转移到的状态
+  /// @param[in] state ：转移起点状态
+  /// @param[in] c_transform ：转移条件
+  /// @return 返回转移到的状态
+  /// @retval kDeadState ：无法转移
+  /// @note 转移不在缓存中时构建转移到的状态，可能清空缓存
+  StateIndex Transform(StateIndex state, char c_transform) {
+    const uint8_t byte_class =
+        lazy_dfa_config_->char_to_class[static_cast<unsigned char>(
+            c_transform)];
+    StateIndex next_state =
+        transitions_[state * lazy_dfa_config_->class_num + byte_class];
+    if (next_state == kUnknownState) [[unlikely]] {
+      next_state = TransformConstruct(state, byte_class);
+    }
+    return next_state;
+  }
+  /// @brief 获取状态对应单词的附属数据
+  /// @param[in] state ：状态编号
+  /// @return 返回单词附属数据的指针，非接受状态返回nullptr
+  /// @note 返回的指针指向配置中的数据，清空缓存后仍然有效
+  const WordAttachedData* GetWordAttachedData(StateIndex state) const {
+    return state_word_attached_data_[state];
+  }
+  /// @brief 获取缓存中的状态数目
+  /// @return 返回缓存中的状态数目
+  size_t GetStateNum() const { return state_word_attached_data_.size(); }
+  /// @brief 获取清空缓存的次数
+  /// @return 返回LazyDfaInit后清空缓存的次数
+  size_t GetFlushTimes() const { return flush_times_; }
+
+ private:
+  /// @class StateMembersHasher lazy_dfa.h
+  /// @brief 哈希状态包含的NFA节点编号集合
+  struct StateMembersHasher {
+    size_t operator()(const std::vector<uint32_t>& members) const;
+  };
+
+  /// @brief 构建初始状态并填写root_state_
+  void RootStateConstruct();
+  /// @brief 计算状态在给定字节等价类下转移到的状态
+  /// @param[in] state ：转移起点状态
+  /// @param[in] byte_class ：字节等价类
+  /// @return 返回转移到的状态
+  /// @retval kDeadState ：无法转移
+  /// @note 未清空缓存时将结果写入转移表
+  StateIndex TransformConstruct(StateIndex state, uint8_t byte_class);
+  /// @brief 查找next_members_对应的状态，不存在则添加
+  /// @param[in] word_closure ：状态代表的最高优先级单词所在的闭包编号，
+  /// 不代表任何单词时为kNoWordClosure
+  /// @return 返回状态编号
+  /// @note 添加后缓存占用的内存超过上限时先清空缓存再添加
+  StateIndex FindOrInsertState(size_t word_closure);
+  /// @brief 清空缓存的所有状态
+  void FlushCache();
+
+  /// @brief 表示状态不代表任何单词的闭包编号
+  static constexpr size_t kNoWordClosure = SIZE_MAX;
+
+  /// @brief 压缩编号后的NFA
+  const LazyDfaConfig* lazy_dfa_config_ = nullptr;
+  /// @brief 缓存的状态最多占用的内存（字节）
+  size_t max_cache_size_ = kDefaultMaxCacheSize;
+  /// @brief 缓存的状态当前占用的内存（估计值，字节）
+  size_t cache_size_ = 0;
+  /// @brief 清空缓存的次数
+  size_t flush_times_ = 0;
+  /// @brief 初始状态，不在缓存中时为kUnknownState
+  StateIndex root_state_ = kUnknownState;
+  /// @brief NFA节点编号集合到状态编号的映射
+  std::unordered_map<std::vector<uint32_t>, StateIndex, StateMembersHasher>
+      members_to_state_;
+  /// @brief 每个状态包含的NFA节点编号集合，指向members_to_state_中的键
+  std::vector<const std::vector<uint32_t>*> state_members_;
+  /// @brief 每个状态对应单词的附属数据，非接受状态为nullptr
+  std::vector<const WordAttachedData*> state_word_attached_data_;
+  /// @brief 转移表，下标为状态编号*class_num+字节等价类
+  /// @note 未计算的转移为kUnknownState
+  std::vector<StateIndex> transitions_;
+  /// @brief 每个字节等价类中最小的字节
+  std::vector<uint8_t> class_first_byte_;
+  /// @brief 计算转移时使用的缓冲区，存储转移到的集合
+  std::vector<uint32_t> next_members_;
+  /// @brief 计算转移时标记已加入next_members_的节点，值等于mark_generation_
+  /// 代表已加入
+  std::vector<uint32_t> node_marks_;
+  /// @brief 本次计算转移使用的标记
+  uint32_t mark_generation_ = 0;
+};
+
+}  // namespace frontend::parser::dfa_parser
+#endif  /// !PARSER_DFAPARSER_LAZYDFA_H_
@@ -0,0 +1,153 @@
+﻿#include "Parser/DfaParser/simd_scanner.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#define FRONTEND_SIMD_SCANNER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif  // _MSC_VER
+#endif
+
+#if defined(FRONTEND_SIMD_SCANNER_X86) && defined(__GNUC__)
+/// GCC/Clang需要为使用AVX2指令的函数单独开启指令集，MSVC不需要
+#define FRONTEND_TARGET_AVX2 __attribute__((target("avx2")))
+#define FRONTEND_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define FRONTEND_TARGET_AVX2
+#define FRONTEND_TARGET_SSE2
+#endif
+
+namespace frontend::parser::dfa_parser::simd_scanner {
+
+const ByteRanges& GetWhiteSpaceRanges() {
+  // '\t' '\n' '\v' '\f' '\r'和' '
+  static const ByteRanges white_space_ranges{.range_num = 2,
+                                             .range_begin = {'\t', ' '},
+                                             .range_end = {'\r', ' '}};
+  return white_space_ranges;
+}
+
+#ifdef FRONTEND_SIMD_SCANNER_X86
+namespace {
+/// @brief 使用SSE2每次扫描16个字节
+FRONTEND_TARGET_SSE2 size_t SpanSse2(const char* begin, const char* end,
+                                         const ByteRanges& ranges) {
+  constexpr size_t kBlockSize = 16;
+  // 判断x属于[begin,end]的方法：(x-begin)按无符号数比较<=(end-begin)
+  // 无符号比较a<=b等价于max(a,b)==b
+  __m128i range_begin[ByteRanges::kMaxRangeNum];
+  __m128i range_width[ByteRanges::kMaxRangeNum];
+  for (size_t i = 0; i < ranges.range_num; i++) {
+    range_begin[i] = _mm_set1_epi8(static_cast<char>(ranges.range_begin[i]));
+    range_width[i] = _mm_set1_epi8(
+        static_cast<char>(ranges.range_end[i] - ranges.range_begin[i]));
+  }
+  const char* block_begin = begin;
+  while (static_cast<size_t>(end - block_begin) >= kBlockSize) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block_begin));
+    __m128i in_ranges = _mm_setzero_si128();
+    for (size_t i = 0; i < ranges.range_num; i++) {
+      __m128i distance = _mm_sub_epi8(block, range_begin[i]);
+      in_ranges = _mm_or_si128(
+          in_ranges, _mm_cmpeq_epi8(_mm_max_epu8(distance, range_width[i]),
+                                    range_width[i]));
+    }
+    uint32_t member_mask = static_cast<uint32_t>(_mm_movemask_epi8(in_ranges));
+    if (member_mask == 0xFFFF) [[likely]] {
+      // 整块都属于集合
+      block_begin += kBlockSize;
+    } else {
+      // 第一个不属于集合的字符之前的部分
+      block_begin += std::countr_one(member_mask);
+      break;
+    }
+  }
+  return block_begin - begin;
+}
+
+/// @brief 使用AVX2每次扫描32个字节
+FRONTEND_TARGET_AVX2 size_t SpanAvx2(const char* begin, const char* end,
+                                         const ByteRanges& ranges) {
+  constexpr size_t kBlockSize = 32;
+  // 判断方法同SpanSse2
+  __m256i range_begin[ByteRanges::kMaxRangeNum];
+  __m256i range_width[ByteRanges::kMaxRangeNum];
+  for (size_t i = 0; i < ranges.range_num; i++) {
+    range_begin[i] =
+        _mm256_set1_epi8(static_cast<char>(ranges.range_begin[i]));
+    range_width[i] = _mm256_set1_epi8(
+        static_cast<char>(ranges.range_end[i] - ranges.range_begin[i]));
+  }
+  const char* block_begin = begin;
+  while (static_cast<size_t>(end - block_begin) >= kBlockSize) {
+    __m256i block =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block_begin));
+    __m256i in_ranges = _mm256_setzero_si256();
+    for (size_t i = 0; i < ranges.range_num; i++) {
+      __m256i distance = _mm256_sub_epi8(block, range_begin[i]);
+      in_ranges = _mm256_or_si256(
+          in_ranges,
+          _mm256_cmpeq_epi8(_mm256_max_epu8(distance, range_width[i]),
+                            range_width[i]));
+    }
+    uint32_t member_mask =
+        static_cast<uint32_t>(_mm256_movemask_epi8(in_ranges));
+    if (member_mask == UINT32_MAX) [[likely]] {
+      // 整块都属于集合
+      block_begin += kBlockSize;
+    } else {
+      // 第一个不属于集合的字符之前的部分
+      block_begin += std::countr_one(member_mask);
+      break;
+    }
+  }
+  return block_begin - begin;
+}
+
+/// @brief 检测CPU支持的指令集并选择扫描函数
+SpanFunction DetectSpanFunction() {
+#ifdef _MSC_VER
+  int cpu_info[4];
+  __cpuid(cpu_info, 0);
+  int max_function_id = cpu_info[0];
+  __cpuid(cpu_info, 1);
+  bool support_sse2 = (cpu_info[3] & (1 << 26)) != 0;
+  // AVX2需要操作系统支持保存YMM寄存器
+  bool os_support_ymm = (cpu_info[2] & (1 << 27)) != 0 &&
+                        (_xgetbv(0) & 0x6) == 0x6;
+  bool support_avx2 = false;
+  if (max_function_id >= 7 && os_support_ymm) {
+    __cpuidex(cpu_info, 7, 0);
+    support_avx2 = (cpu_info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  bool support_sse2 = __builtin_cpu_supports("sse2");
+  bool support_avx2 = __builtin_cpu_supports("avx2");
+#endif  // _MSC_VER
+  if (support_avx2) {
+    return SpanAvx2;
+  } else if (support_sse2) {
+    return SpanSse2;
+  } else {
+    return nullptr;
+  }
+}
+}  // namespace
+#endif  // FRONTEND_SIMD_SCANNER_X86
+
+SpanFunction GetSpanFunction() {
+#ifdef FRONTEND_SIMD_SCANNER_X86
+  static const SpanFunction span_function = DetectSpanFunction();
+  return span_function;
+#else
+  return nullptr;
+#endif  // FRONTEND_SIMD_SCANNER_X86
+}
+
+}  // namespace frontend::parser::dfa_parser::simd_scanner
@@ -0,0 +1,37 @@
+﻿/// @file simd_scanner.h
+/// @brief DFA解析器使用的SIMD批量扫描函数
+/// @details
+/// 一次判断16（SSE2）或32（AVX2）个字节是否属于给定的字节集合，用于跳过空白字符
+/// 和移入停留在自循环状态中的字符（如标识符的[a-zA-Z0-9_]*部分）
+/// 运行时检测CPU支持的指令集，不支持SIMD时DFA解析器逐字节转移
+#ifndef PARSER_DFAPARSER_SIMDSCANNER_H_
+#define PARSER_DFAPARSER_SIMDSCANNER_H_
+
+#include "Generator/export_types.h"
+
+namespace frontend::parser::dfa_parser::simd_scanner {
+
+using frontend::generator::dfa_generator::ByteRanges;
+
+/// @brief 扫描函数类型
+/// @param[in] begin ：扫描起点
+/// @param[in] end ：输入尾后字符
+/// @param[in] ranges ：字节集合
+/// @return 返回从扫描起点开始连续属于字节集合的字符数
+/// @note 仅扫描完整的块，剩余不足一块的字符和块中第一个不属于集合的字符
+/// 之后的部分不扫描，由调用方逐字节处理
+using SpanFunction = size_t (*)(const char* begin, const char* end,
+                                const ByteRanges& ranges);
+
+/// @brief 获取当前CPU支持的最快的扫描函数
+/// @return 返回扫描函数
+/// @retval nullptr ：CPU不支持SIMD，应逐字节处理
+/// @note 仅在第一次调用时检测CPU
+SpanFunction GetSpanFunction();
+
+/// @brief 获取空白字符（与C locale下std::isspace相同）构成的字节集合
+/// @return 返回空白字符集合的const引用
+const ByteRanges& GetWhiteSpaceRanges();
+
+}  // namespace frontend::parser::dfa_parser::simd_scanner
+#endif  /// !PARSER_DFAPARSER_SIMDSCANNER_H_
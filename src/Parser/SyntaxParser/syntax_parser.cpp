@@ -1,6 +1,7 @@
 ﻿#include "syntax_parser.h"
 
 #include <format>
+#include <thread>
 namespace frontend::parser::syntax_parser {
 void SyntaxParser::LoadConfig() {
   std::ifstream config_file(frontend::common::kSyntaxConfigFileName,
@@ -16,6 +17,25 @@ bool SyntaxParser::Parse(const std::string& filename) {
               std::format("打开文件\"{:}\"失败，请检查\n", filename));
     return false;
   }
+  input_name_ = filename;
+  return ParseInput();
+}
+
+bool SyntaxParser::Parse(std::string_view source,
+                         std::string_view virtual_name) {
+  dfa_parser_.SetInputBuffer(source);
+  input_name_ = virtual_name;
+  return ParseInput();
+}
+
+bool SyntaxParser::ParseInput() {
+  // 清空上一次解析剩余的单词
+  token_buffer_.Clear();
+  next_token_index_ = 0;
+  if (dfa_parser_.GetInputContent().size() >= kParallelLexMinInputSize) {
+    // 输入很大时多线程获取全部单词，结果与逐批获取相同
+    dfa_parser_.LexParallel(token_buffer_, std::thread::hardware_concurrency());
+  }
   GetNextWord();
   // 清空解析数据栈
   auto old_parsing_stack = std::stack<ParsingData>();
@@ -33,6 +53,22 @@ bool SyntaxParser::Parse(const std::string& filename) {
   return true;
 }
 
+void SyntaxParser::GetNextWord() {
+  if (next_token_index_ == token_buffer_.Size()) [[unlikely]] {
+    dfa_parser_.LexBatch(token_buffer_, kTokenBatchSize);
+    next_token_index_ = 0;
+  }
+  const size_t index = next_token_index_++;
+  WordInfo& word_info = GetWaitingProcessWordInfo();
+  word_info.word_attached_data_ = dfa_parser_.GetWordAttachedData(
+      token_buffer_.production_node_ids[index]);
+  word_info.symbol_ = dfa_parser_.GetInputContent().substr(
+      token_buffer_.offsets[index], token_buffer_.lengths[index]);
+  // 批量获取单词时DFA分析机的位置领先于当前单词，设置为获取该单词后的位置
+  // 只记录偏移，需要时再计算行数和列数
+  SetOffset(token_buffer_.offsets[index] + token_buffer_.lengths[index]);
+}
+
 void SyntaxParser::TerminalWordWaitingProcess() {
   assert(GetWaitingProcessWordInfo().word_attached_data_.node_type ==
              ProductionNodeType::kTerminalNode ||
@@ -54,8 +90,11 @@ void SyntaxParser::TerminalWordWaitingProcess() {
       break;
     // TODO 添加错误处理功能
     [[unlikely]] case ActionType::kError:
-      LOG_ERROR("Parser", std::format("Line: {:} Column: {:}: Syntax Error!",
-                                      GetLine() + 1, GetColumn() + 1))
+      LOG_ERROR("Parser",
+                std::format("{:} Line: {:} Column: {:} Offset: {:}: "
+                            "Syntax Error!",
+                            input_name_, GetLine() + 1, GetColumn() + 1,
+                            token_buffer_.offsets[next_token_index_ - 1]))
       exit(-1);
       break;
     case ActionType::kReduct:
@@ -122,7 +161,8 @@ inline void SyntaxParser::ShiftTerminalWord(
   parsing_data_now.shift_node_id =
       word_info.word_attached_data_.production_node_id;
   // 添加待移入节点信息到当前解析用信息
-  parsing_data_now.word_data_to_user = std::move(word_info.symbol_);
+  // 单词引用输入文件内容，仅在移入时复制一份交给用户
+  parsing_data_now.word_data_to_user = std::string(word_info.symbol_);
   // 如果移入了运算符则更新优先级为新的优先级
   OperatorPriority new_parsing_data_priority;
   if (word_info.word_attached_data_.node_type ==
@@ -20,6 +20,10 @@ namespace frontend::parser::syntax_parser {
 /// @brief 语法分析机
 class SyntaxParser {
   using DfaParser = frontend::parser::dfa_parser::DfaParser;
+  /// @brief 每次从DFA分析机批量获取的单词数目
+  static constexpr size_t kTokenBatchSize = 4096;
+  /// @brief 输入不小于该字节数时使用多线程一次性获取全部单词
+  static constexpr size_t kParallelLexMinInputSize = 64 * 1024 * 1024;
 
  public:
   /// @brief DFA引擎返回的单词信息
@@ -92,7 +96,8 @@ class SyntaxParser {
   /// @brief 获取DFA返回的待移入单词的数据
   WordInfo& GetWaitingProcessWordInfo() { return dfa_return_data_; }
   /// @brief 获取下一个单词的数据并存在dfa_return_data_中
-  void GetNextWord() { SetDfaReturnData(dfa_parser_.GetNextWord()); }
+  /// @note 从批量获取的单词缓冲区中取出单词，缓冲区为空时批量获取下一批
+  void GetNextWord();
   /// @brief 获取根语法分析表条目D
   /// @return 返回根语法分析表条目ID
   SyntaxAnalysisTableEntryId GetRootParsingEntryId() const {
@@ -153,6 +158,15 @@ class SyntaxParser {
   /// @retval true 解析成功
   /// @retval false 无法打开文件/解析失败
   bool Parse(const std::string& filename);
+  /// @brief 分析内存中的代码并构建AST
+  /// @param[in] source ：代码内容
+  /// @param[in] virtual_name ：代码的名称，仅用于输出错误信息
+  /// @return 解析是否成功
+  /// @retval true 解析成功
+  /// @retval false 解析失败
+  /// @note 直接在source上解析，不访问文件系统；报告的位置相对source开头
+  /// @attention 解析完成前调用方必须保证source有效
+  bool Parse(std::string_view source, std::string_view virtual_name);
 
  private:
   /// @brief 允许序列化类访问
@@ -173,6 +187,11 @@ class SyntaxParser {
   /// 将序列化分为保存与加载，Parser仅加载配置，不保存
   BOOST_SERIALIZATION_SPLIT_MEMBER()
 
+  /// @brief 在已设置好的DFA输入上执行语法分析
+  /// @return 解析是否成功
+  /// @note Parse的子过程，调用前需要设置DFA分析机的输入
+  bool ParseInput();
+
   /// @brief 处理待移入单词是终结节点的情况
   /// @details
   /// 1.自动选择移入和归并
@@ -221,6 +240,12 @@ class SyntaxParser {
   /// @brief 语法分析表，只有加载配置时可以修改
   const SyntaxAnalysisTableType syntax_analysis_table_;
 
+  /// @brief 当前解析的输入名（文件名或用户指定的名称），用于输出错误信息
+  std::string input_name_;
+  /// @brief 批量获取的单词
+  DfaParser::TokenBuffer token_buffer_;
+  /// @brief 下一个待处理的单词在token_buffer_中的下标
+  size_t next_token_index_ = 0;
   /// @brief DFA返回的数据
   WordInfo dfa_return_data_;
   /// @brief 解析用数据栈，栈顶为当前解析数据
@@ -0,0 +1,510 @@
+﻿/// @file lexer_bench.cpp
+/// @brief DFA解析器吞吐量基准测试
+/// @details
+/// 生成确定性的合成C源码（单词种类与
+/// Config/ProductionConfig/C-parser-frontend-production_config-inc.h一致），
+/// 使用DfaParser获取全部单词，输出MB/s、单词/s、每个单词的内存分配次数和
+/// 每字节周期数，并可以输出JSON用于跟踪不同DFA表格式和输入方式的性能变化
+/// 用法：
+/// lexer_bench [--sizes-mb 1,16,64] [--mixes balanced,identifiers,...]
+///             [--repeat 5] [--input buffer|file] [--threads 0] [--seed 1]
+///             [--json 文件名，"-"代表标准输出]
+/// 需要在词法分析机配置文件（frontend::common::kDfaConfigFileName）所在目录
+/// 下运行，使用生成的词法分析器构建时不需要配置文件
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Parser/DfaParser/dfa_parser.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#define FRONTEND_LEXER_BENCH_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif  // _MSC_VER
+#endif
+
+namespace {
+/// @brief 程序运行以来调用operator new的次数
+std::atomic<size_t> allocation_count = 0;
+}  // namespace
+
+/// 替换全局operator new以统计内存分配次数
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) [[likely]] {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+namespace frontend::parser::lexer_bench {
+
+using frontend::parser::dfa_parser::DfaParser;
+
+/// @brief 合成源码的单词组成
+enum class CorpusMix {
+  kBalanced,     ///< 接近普通C源码的组成
+  kIdentifiers,  ///< 以长短不一的标识符和关键字为主
+  kNumbers,      ///< 以整数和小数为主
+  kStrings,      ///< 以字符串和字符为主
+  kOperators     ///< 以运算符为主
+};
+
+/// @brief 所有单词组成及其名称
+constexpr std::pair<CorpusMix, const char*> kCorpusMixNames[] = {
+    {CorpusMix::kBalanced, "balanced"},
+    {CorpusMix::kIdentifiers, "identifiers"},
+    {CorpusMix::kNumbers, "numbers"},
+    {CorpusMix::kStrings, "strings"},
+    {CorpusMix::kOperators, "operators"}};
+
+/// @brief 获取单词组成的名称
+/// @param[in] mix ：单词组成
+/// @return 返回单词组成的名称
+const char* GetCorpusMixName(CorpusMix mix) {
+  for (const auto& [mix_now, name] : kCorpusMixNames) {
+    if (mix_now == mix) {
+      return name;
+    }
+  }
+  assert(false);
+  return "";
+}
+
+/// @class CorpusGenerator lexer_bench.cpp
+/// @brief 生成确定性的合成C源码
+/// @details
+/// 使用固定种子的std::mt19937_64（标准规定了其输出序列）并自行缩小范围
+/// （std::uniform_int_distribution的算法由实现决定），
+/// 相同的种子、组成和大小在任何平台上生成相同的源码
+/// @note 配置中Str的正则为".*"，按最长匹配原则同一文件中的多个字符串会
+/// 合并为一个到最后一个双引号为止的单词，所以只有strings组成包含字符串，
+/// 用于测试长单词
+class CorpusGenerator {
+ public:
+  CorpusGenerator(CorpusMix mix, uint64_t seed) : mix_(mix), engine_(seed) {}
+
+  /// @brief 生成源码
+  /// @param[in] size ：源码的最小字节数
+  /// @return 返回生成的源码，以完整的语句结尾
+  std::string Generate(size_t size) {
+    std::string source;
+    source.reserve(size + 256);
+    while (source.size() < size) {
+      AppendStatement(source);
+    }
+    return source;
+  }
+
+ private:
+  /// @brief 生成[0,bound)中的随机数
+  /// @note 取模带来的偏差对生成源码没有影响
+  size_t Random(size_t bound) { return engine_() % bound; }
+  /// @brief 以percent%的概率返回true
+  bool Chance(size_t percent) { return Random(100) < percent; }
+
+  /// @brief 添加一条语句
+  void AppendStatement(std::string& source) {
+    static constexpr const char* kTypes[] = {
+        "char", "short", "int", "long", "float", "double", "unsigned int"};
+    // 缩进，测试跳过空白字符的性能
+    source.append(Random(4) * 2, ' ');
+    switch (Random(8)) {
+      case 0:
+        source += kTypes[Random(std::size(kTypes))];
+        source += ' ';
+        AppendIdentifier(source);
+        source += " = ";
+        AppendExpression(source);
+        source += ";\n";
+        break;
+      case 1:
+        source += "if (";
+        AppendExpression(source);
+        source += ") {\n";
+        break;
+      case 2:
+        source += "} else {\n";
+        break;
+      case 3:
+        source += "while (";
+        AppendExpression(source);
+        source += ") {\n";
+        break;
+      case 4:
+        source += "}\n";
+        break;
+      case 5:
+        source += "return ";
+        AppendExpression(source);
+        source += ";\n";
+        break;
+      default:
+        AppendIdentifier(source);
+        source += " = ";
+        AppendExpression(source);
+        source += ";\n";
+        break;
+    }
+  }
+  /// @brief 添加表达式
+  void AppendExpression(std::string& source) {
+    static constexpr const char* kBinaryOperators[] = {
+        "+",  "-",  "*",  "/",  "%",  "<<", ">>", "&",  "|",
+        "^",  "&&", "||", "==", "!=", "<",  "<=", ">",  ">="};
+    size_t operand_num = 1 + Random(mix_ == CorpusMix::kOperators ? 8 : 3);
+    for (size_t i = 0; i < operand_num; i++) {
+      if (i != 0) {
+        // 运算符两侧保留空格，避免"+1"被识别为Num
+        source += ' ';
+        source += kBinaryOperators[Random(std::size(kBinaryOperators))];
+        source += ' ';
+      }
+      AppendOperand(source);
+    }
+  }
+  /// @brief 添加操作数
+  void AppendOperand(std::string& source) {
+    // 各组成下标识符、数字、字符串、字符和带括号的单目运算的百分比
+    size_t identifier_percent, number_percent, string_percent,
+        character_percent;
+    switch (mix_) {
+      case CorpusMix::kIdentifiers:
+        identifier_percent = 85, number_percent = 5, string_percent = 0,
+        character_percent = 0;
+        break;
+      case CorpusMix::kNumbers:
+        identifier_percent = 15, number_percent = 80, string_percent = 0,
+        character_percent = 0;
+        break;
+      case CorpusMix::kStrings:
+        identifier_percent = 20, number_percent = 10, string_percent = 45,
+        character_percent = 20;
+        break;
+      case CorpusMix::kOperators:
+        identifier_percent = 40, number_percent = 30, string_percent = 0,
+        character_percent = 0;
+        break;
+      default:
+        identifier_percent = 55, number_percent = 25, string_percent = 0,
+        character_percent = 3;
+        break;
+    }
+    size_t choice = Random(100);
+    if (choice < identifier_percent) {
+      AppendIdentifier(source);
+      if (Chance(10)) {
+        source += Chance(50) ? "++" : "--";
+      }
+    } else if ((choice -= identifier_percent) < number_percent) {
+      AppendNumber(source);
+    } else if ((choice -= number_percent) < string_percent) {
+      AppendString(source);
+    } else if ((choice -= string_percent) < character_percent) {
+      source += '\'';
+      source += static_cast<char>('a' + Random(26));
+      source += '\'';
+    } else {
+      source += Chance(50) ? "!(" : "~(";
+      AppendIdentifier(source);
+      source += ')';
+    }
+  }
+  /// @brief 添加标识符
+  void AppendIdentifier(std::string& source) {
+    static constexpr char kFirstCharacters[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+    static constexpr char kCharacters[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+    // 长度分布偏向短标识符，偶尔出现长标识符
+    size_t length = 1 + Random(Chance(10) ? 32 : 8);
+    source += kFirstCharacters[Random(std::size(kFirstCharacters) - 1)];
+    for (size_t i = 1; i < length; i++) {
+      source += kCharacters[Random(std::size(kCharacters) - 1)];
+    }
+  }
+  /// @brief 添加整数或小数
+  void AppendNumber(std::string& source) {
+    source += std::to_string(Random(Chance(20) ? 1000000000 : 100));
+    if (Chance(20)) {
+      source += '.';
+      source += std::to_string(Random(10000));
+    }
+  }
+  /// @brief 添加字符串
+  void AppendString(std::string& source) {
+    static constexpr char kCharacters[] =
+        "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789,.!";
+    source += '"';
+    size_t length = Random(48);
+    for (size_t i = 0; i < length; i++) {
+      source += kCharacters[Random(std::size(kCharacters) - 1)];
+    }
+    source += '"';
+  }
+
+  /// @brief 单词组成
+  CorpusMix mix_;
+  /// @brief 随机数引擎
+  std::mt19937_64 engine_;
+};
+
+/// @brief 输入方式
+enum class InputKind {
+  kBuffer,  ///< DfaParser::SetInputBuffer
+  kFile     ///< 写入临时文件后DfaParser::SetInputFile
+};
+
+/// @brief 一次基准测试的结果
+struct BenchResult {
+  CorpusMix mix;
+  size_t size_bytes;
+  size_t token_num;
+  /// @brief 多次运行中最快一次的秒数
+  double seconds;
+  /// @brief 最快一次运行的周期数，不支持rdtsc时为0
+  uint64_t cycles;
+  /// @brief 每次运行的平均内存分配次数
+  double allocations;
+};
+
+/// @brief 读取时间戳计数器
+/// @return 返回当前周期数，不支持rdtsc时返回0
+uint64_t ReadCycleCounter() {
+#ifdef FRONTEND_LEXER_BENCH_RDTSC
+  return __rdtsc();
+#else
+  return 0;
+#endif  // FRONTEND_LEXER_BENCH_RDTSC
+}
+
+/// @brief 使用DfaParser获取全部单词并计时
+/// @param[in] dfa_parser ：已加载配置的DFA解析器
+/// @param[in] corpus ：源码
+/// @param[in] mix ：源码的单词组成
+/// @param[in] repeat ：运行次数
+/// @param[in] input_kind ：输入方式
+/// @param[in] thread_num ：大于0时使用LexParallel，否则使用LexBatch
+/// @return 返回测试结果
+BenchResult RunLexer(DfaParser& dfa_parser, const std::string& corpus,
+                     CorpusMix mix, size_t repeat, InputKind input_kind,
+                     size_t thread_num) {
+  constexpr size_t kTokenBatchSize = 4096;
+  constexpr const char* kCorpusFileName = "lexer_bench_corpus.c";
+  if (input_kind == InputKind::kFile) {
+    std::ofstream corpus_file(kCorpusFileName, std::ios_base::binary);
+    corpus_file.write(corpus.data(), corpus.size());
+  }
+  const auto end_of_file_id =
+      dfa_parser.GetEndOfFileSavedData().production_node_id;
+  BenchResult result{.mix = mix,
+                     .size_bytes = corpus.size(),
+                     .token_num = 0,
+                     .seconds = 0.0,
+                     .cycles = 0,
+                     .allocations = 0.0};
+  DfaParser::TokenBuffer token_buffer;
+  size_t total_allocations = 0;
+  for (size_t i = 0; i < repeat; i++) {
+    size_t allocations_begin = allocation_count.load();
+    auto time_begin = std::chrono::steady_clock::now();
+    uint64_t cycles_begin = ReadCycleCounter();
+    if (input_kind == InputKind::kFile) {
+      if (!dfa_parser.SetInputFile(kCorpusFileName)) [[unlikely]] {
+        std::cerr << std::format("打开文件\"{:}\"失败\n", kCorpusFileName);
+        exit(-1);
+      }
+    } else {
+      dfa_parser.SetInputBuffer(corpus);
+    }
+    size_t token_num = 0;
+    if (thread_num > 0) {
+      dfa_parser.LexParallel(token_buffer, thread_num);
+    } else {
+      dfa_parser.LexBatch(token_buffer, kTokenBatchSize);
+    }
+    while (true) {
+      token_num += token_buffer.Size();
+      if (token_buffer.Size() == 0 ||
+          token_buffer.production_node_ids.back() == end_of_file_id) {
+        break;
+      }
+      dfa_parser.LexBatch(token_buffer, kTokenBatchSize);
+    }
+    uint64_t cycles = ReadCycleCounter() - cycles_begin;
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - time_begin)
+                         .count();
+    total_allocations += allocation_count.load() - allocations_begin;
+    // 不计文件尾单词
+    result.token_num = token_num - 1;
+    if (i == 0 || seconds < result.seconds) {
+      result.seconds = seconds;
+      result.cycles = cycles;
+    }
+  }
+  dfa_parser.Reset();
+  if (input_kind == InputKind::kFile) {
+    std::remove(kCorpusFileName);
+  }
+  result.allocations = static_cast<double>(total_allocations) / repeat;
+  return result;
+}
+
+/// @brief 将测试结果格式化为JSON
+/// @param[in] results ：测试结果
+/// @param[in] input_kind ：输入方式
+/// @param[in] thread_num ：LexParallel使用的线程数，0代表使用LexBatch
+/// @param[in] seed ：生成源码使用的种子
+/// @return 返回JSON字符串
+std::string FormatJson(const std::vector<BenchResult>& results,
+                       InputKind input_kind, size_t thread_num,
+                       uint64_t seed) {
+#ifdef USE_GENERATED_DFA_LEXER
+  constexpr const char* kLexerKind = "generated";
+#else
+  constexpr const char* kLexerKind = "table";
+#endif  // USE_GENERATED_DFA_LEXER
+  std::string json = std::format(
+      "{{\n  \"lexer\": \"{:}\",\n  \"input\": \"{:}\",\n"
+      "  \"threads\": {:},\n  \"seed\": {:},\n  \"results\": [",
+      kLexerKind, input_kind == InputKind::kFile ? "file" : "buffer",
+      thread_num, seed);
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult& result = results[i];
+    double megabytes = static_cast<double>(result.size_bytes) / (1024 * 1024);
+    json += std::format(
+        "{:}\n    {{\"mix\": \"{:}\", \"size_bytes\": {:}, \"tokens\": {:}, "
+        "\"seconds\": {:.6f}, \"mb_per_second\": {:.2f}, "
+        "\"tokens_per_second\": {:.0f}, \"allocations_per_token\": {:.6f}, "
+        "\"cycles_per_byte\": {:}}}",
+        i == 0 ? "" : ",", GetCorpusMixName(result.mix), result.size_bytes,
+        result.token_num, result.seconds, megabytes / result.seconds,
+        result.token_num / result.seconds,
+        result.allocations / std::max(result.token_num, size_t(1)),
+        result.cycles == 0
+            ? std::string("null")
+            : std::format("{:.3f}", static_cast<double>(result.cycles) /
+                                        result.size_bytes));
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+/// @brief 解析逗号分隔的列表
+/// @param[in] list ：逗号分隔的列表
+/// @return 返回各项
+std::vector<std::string> SplitList(std::string_view list) {
+  std::vector<std::string> items;
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    items.emplace_back(list.substr(0, comma));
+    list = comma == std::string_view::npos ? std::string_view()
+                                           : list.substr(comma + 1);
+  }
+  return items;
+}
+
+}  // namespace frontend::parser::lexer_bench
+
+int main(int argc, char** argv) {
+  using namespace frontend::parser::lexer_bench;
+  std::vector<size_t> sizes_mb = {1, 16, 64};
+  std::vector<CorpusMix> mixes;
+  for (const auto& [mix, name] : kCorpusMixNames) {
+    mixes.push_back(mix);
+  }
+  size_t repeat = 5;
+  size_t thread_num = 0;
+  uint64_t seed = 1;
+  InputKind input_kind = InputKind::kBuffer;
+  std::string json_file_name;
+  for (int i = 1; i < argc; i++) {
+    std::string_view option = argv[i];
+    if (i + 1 == argc) [[unlikely]] {
+      std::cerr << std::format("选项{:}缺少参数\n", option);
+      return -1;
+    }
+    std::string_view value = argv[++i];
+    if (option == "--sizes-mb") {
+      sizes_mb.clear();
+      for (const auto& size : SplitList(value)) {
+        sizes_mb.push_back(std::stoull(size));
+      }
+    } else if (option == "--mixes") {
+      mixes.clear();
+      for (const auto& name : SplitList(value)) {
+        auto iter = std::find_if(
+            std::begin(kCorpusMixNames), std::end(kCorpusMixNames),
+            [&name](const auto& mix_and_name) {
+              return name == mix_and_name.second;
+            });
+        if (iter == std::end(kCorpusMixNames)) [[unlikely]] {
+          std::cerr << std::format("未知的单词组成{:}\n", name);
+          return -1;
+        }
+        mixes.push_back(iter->first);
+      }
+    } else if (option == "--repeat") {
+      repeat = std::max(std::stoull(std::string(value)), 1ull);
+    } else if (option == "--threads") {
+      thread_num = std::stoull(std::string(value));
+    } else if (option == "--seed") {
+      seed = std::stoull(std::string(value));
+    } else if (option == "--input") {
+      input_kind = value == "file" ? InputKind::kFile : InputKind::kBuffer;
+    } else if (option == "--json") {
+      json_file_name = value;
+    } else {
+      std::cerr << std::format("未知的选项{:}\n", option);
+      return -1;
+    }
+  }
+
+  static DfaParser dfa_parser;
+  dfa_parser.LoadConfig();
+  std::vector<BenchResult> results;
+  for (CorpusMix mix : mixes) {
+    for (size_t size_mb : sizes_mb) {
+      std::string corpus =
+          CorpusGenerator(mix, seed).Generate(size_mb * 1024 * 1024);
+      const BenchResult& result = results.emplace_back(RunLexer(
+          dfa_parser, corpus, mix, repeat, input_kind, thread_num));
+      std::cout << std::format(
+          "{:<12} {:>5} MB {:>10} tokens {:>9.2f} MB/s {:>12.0f} tokens/s "
+          "{:>8.4f} allocs/token {:>7.3f} cycles/byte\n",
+          GetCorpusMixName(mix), size_mb, result.token_num,
+          static_cast<double>(result.size_bytes) / (1024 * 1024) /
+              result.seconds,
+          result.token_num / result.seconds,
+          result.allocations / std::max(result.token_num, size_t(1)),
+          static_cast<double>(result.cycles) / result.size_bytes);
+    }
+  }
+  if (!json_file_name.empty()) {
+    std::string json = FormatJson(results, input_kind, thread_num, seed);
+    if (json_file_name == "-") {
+      std::cout << json;
+    } else {
+      std::ofstream(json_file_name) << json;
+    }
+  }
+}
@@ -1,15 +1,68 @@
 ﻿#include "line_and_column.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace frontend::parser {
-/// @brief 线程全局变量，存储当前解析到的行数
-/// @note 从0开始计数
-static thread_local size_t line_ = 0;
-/// @brief 线程全局变量，存储当前解析到的列数
-/// @note 从0开始计数
-static thread_local size_t column_ = 0;
-
-size_t GetLine() { return line_; }
-size_t GetColumn() { return column_; }
-void SetLine(size_t line) { line_ = line; }
-void SetColumn(size_t column) { column_ = column; }
+/// @brief 线程全局变量，存储当前解析的输入
+static thread_local std::string_view input_;
+/// @brief 线程全局变量，存储当前解析到的位置（相对输入开头的字节偏移）
+static thread_local size_t offset_ = 0;
+/// @brief 线程全局变量，存储当前输入的换行符索引
+static thread_local NewlineIndex newline_index_;
+/// @brief 线程全局变量，标记newline_index_是否已为当前输入构建
+static thread_local bool newline_index_built_ = false;
+
+void NewlineIndex::Build(std::string_view content) {
+  newline_offsets_.clear();
+  const char* const content_begin = content.data();
+  const char* const content_end = content.data() + content.size();
+  const char* newline_position = content_begin;
+  // 标准库的memchr使用向量化实现，每次跳过一批不含换行符的字符
+  while (newline_position != content_end &&
+         (newline_position = static_cast<const char*>(
+              std::memchr(newline_position, '\n',
+                          content_end - newline_position))) != nullptr) {
+    newline_offsets_.push_back(newline_position - content_begin);
+    ++newline_position;
+  }
+}
+
+size_t NewlineIndex::GetLine(size_t offset) const {
+  // offset之前的换行符数目
+  return std::lower_bound(newline_offsets_.begin(), newline_offsets_.end(),
+                          offset) -
+         newline_offsets_.begin();
+}
+
+size_t NewlineIndex::GetColumn(size_t offset) const {
+  size_t line = GetLine(offset);
+  if (line == 0) {
+    return offset;
+  } else {
+    // 上一个换行符之后的字符数
+    return offset - newline_offsets_[line - 1] - 1;
+  }
+}
+
+/// @brief 获取当前输入的换行符索引，未构建则先构建
+/// @return 返回换行符索引的const引用
+static const NewlineIndex& GetNewlineIndex() {
+  if (!newline_index_built_) [[unlikely]] {
+    newline_index_.Build(input_);
+    newline_index_built_ = true;
+  }
+  return newline_index_;
+}
+
+void SetInput(std::string_view content) {
+  input_ = content;
+  offset_ = 0;
+  newline_index_.Clear();
+  newline_index_built_ = false;
+}
+void SetOffset(size_t offset) { offset_ = offset; }
+size_t GetOffset() { return offset_; }
+size_t GetLine() { return GetNewlineIndex().GetLine(offset_); }
+size_t GetColumn() { return GetNewlineIndex().GetColumn(offset_); }
 }  // namespace frontend::parser
\ No newline at end of file
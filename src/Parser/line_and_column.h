@@ -1,28 +1,64 @@
 ﻿/// @file line_and_column.h
-/// @brief 存储当前解析到的源文件行数和列数
-/// @note 表示行数与列数的变量都是thread_loacl修饰的全局变量
+/// @brief 存储当前解析到的源文件位置，按需计算行数和列数
+/// @details
+/// 解析时只记录相对输入开头的字节偏移，需要行数和列数时（输出错误信息、
+/// 规约函数查询位置）才通过换行符索引计算，避免解析每个字符都更新行数和列数
+/// 换行符索引在第一次查询行数或列数时对每个输入构建一次
+/// @note 表示当前位置的变量都是thread_local修饰的全局变量
 #ifndef PARSER_LINE_AND_COLUMN_H_
 #define PARSER_LINE_AND_COLUMN_H_
 
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
 namespace frontend::parser {
 
+/// @class NewlineIndex line_and_column.h
+/// @brief 换行符索引，将字节偏移转换为行数和列数
+class NewlineIndex {
+ public:
+  /// @brief 构建换行符索引
+  /// @param[in] content ：输入的全部内容
+  void Build(std::string_view content);
+  /// @brief 清空索引
+  void Clear() { newline_offsets_.clear(); }
+  /// @brief 获取偏移所在的行数
+  /// @param[in] offset ：相对输入开头的字节偏移
+  /// @return 返回偏移之前的换行符数目，即行数
+  /// @note 从0开始计算
+  size_t GetLine(size_t offset) const;
+  /// @brief 获取偏移所在的列数
+  /// @param[in] offset ：相对输入开头的字节偏移
+  /// @return 返回偏移与它之前最后一个换行符之间的字符数，即列数
+  /// @note 从0开始计算
+  size_t GetColumn(size_t offset) const;
+
+ private:
+  /// @brief 所有换行符相对输入开头的偏移，升序排列
+  std::vector<size_t> newline_offsets_;
+};
+
+/// @brief 设置当前解析的输入
+/// @param[in] content ：输入的全部内容
+/// @note 将当前偏移重置为0，换行符索引在第一次查询行数或列数时构建
+/// @attention 查询行数或列数时content必须有效
+void SetInput(std::string_view content);
+/// @brief 设置当前位置
+/// @param[in] offset ：相对输入开头的字节偏移
+void SetOffset(size_t offset);
+/// @brief 获取当前位置
+/// @return 返回相对输入开头的字节偏移
+size_t GetOffset();
 /// @brief 获取当前行数
 /// @return 返回当前行数
 /// @note 从0开始计算
-extern inline size_t GetLine();
+size_t GetLine();
 /// @brief 获取当前列数
-/// @return 返回当前行数
-/// @note 从0开始计算
-extern inline size_t GetColumn();
-/// @brief 设置当前行数
-/// @param[in] line ：待设置的行数
-/// @note 从0开始计算
-extern inline void SetLine(size_t line);
-/// @brief 设置当前列数
-/// @param[in] column ：待设置的列数
+/// @return 返回当前列数
 /// @note 从0开始计算
-extern inline void SetColumn(size_t column);
+size_t GetColumn();
 
 }  // namespace frontend::parser
 
-#endif  /// !PARSER_LINE_AND_COLUMN_H_
\ No newline at end of file
+#endif  /// !PARSER_LINE_AND_COLUMN_H_